@@ -0,0 +1,550 @@
+#ifndef _BINARY_DATABASE_HH_
+#define _BINARY_DATABASE_HH_
+
+#include <ostream>
+#include <sstream>
+
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <algorithm>
+#include <functional>
+
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+
+#include "ordered_set.hh"
+#include "sequence.hh"
+
+/* binary sequence database
+ *
+ * a fixed header followed by sections padded to 8 bytes, all in native byte
+ * order (the version field doubles as a byte order check):
+ *   dictionary        int64 item values, or for string items uint64 offsets
+ *                     (alphabet_size+1) followed by the characters
+ *   sequence offsets  uint64 (sequence_count+1), into the elements
+ *   element offsets   uint64 (element_count+1), into the items, itemsets only
+ *   items             uint32 item ids, indices into the sorted dictionary
+ *   labels            uint8 (sequence_count), labeled databases only
+ *
+ * the magic number cannot start a text database, so loaders tell the two
+ * formats apart by the first bytes of the file. */
+static const char binary_database_magic[8] = { '\x89', 'S', 'E', 'Q', 'D', 'B', '\r', '\n' };
+static const uint32_t binary_database_version = 1;
+
+enum binary_database_flags {
+	binary_itemset = 1,
+	binary_labeled = 2,
+	binary_strings = 4
+};
+
+struct binary_database_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t flags;
+	uint64_t alphabet_size;
+	uint64_t sequence_count;
+	uint64_t max_length;
+	uint64_t element_count;
+	uint64_t item_count;
+	uint64_t dictionary_size;
+};
+
+/* item type stored in the dictionary for a sequence of Value */
+template <typename Value>
+struct binary_item {
+	typedef Value type;
+};
+
+template <typename Value>
+struct binary_item<ordered_set<Value> > {
+	typedef Value type;
+};
+
+inline bool is_binary_database(const char *begin, const char *end) {
+	return end - begin >= (std::ptrdiff_t) sizeof(binary_database_magic) && std::memcmp(begin, binary_database_magic, sizeof(binary_database_magic)) == 0;
+}
+
+/* reads a string dictionary section: alphabet_size+1 uint64 offsets followed by the characters */
+inline bool load_string_dictionary(const char *dictionary, uint64_t alphabet_size, uint64_t dictionary_size, std::vector<std::string> &values) {
+	if(8 * (alphabet_size + 1) > dictionary_size) {
+		return false;
+	}
+	
+	const uint64_t *offsets = reinterpret_cast<const uint64_t *>(dictionary);
+	const char *characters = dictionary + 8 * (alphabet_size + 1);
+	uint64_t characters_size = dictionary_size - 8 * (alphabet_size + 1);
+	
+	values.resize(alphabet_size);
+	for(uint64_t ii=0; ii < alphabet_size; ii++) {
+		if(offsets[ii] > offsets[ii+1] || offsets[ii+1] > characters_size) {
+			return false;
+		}
+		
+		values[ii].assign(characters + offsets[ii], characters + offsets[ii+1]);
+	}
+	
+	return true;
+}
+
+/* view of a binary database held in memory, sequences are decoded on demand */
+class binary_database {
+	public:
+		binary_database(const char *begin, const char *end) : header(), dictionary(NULL), sequence_offsets(NULL), element_offsets(NULL), items(NULL), labels(NULL), valid(false) {
+			if(!is_binary_database(begin, end) || end - begin < (std::ptrdiff_t) sizeof(binary_database_header)) {
+				return;
+			}
+			
+			std::memcpy(&header, begin, sizeof(header));
+			if(header.version != binary_database_version) {
+				return;
+			}
+			
+			/* counts beyond 2^40 cannot come from a real file, rejecting them keeps the size arithmetic exact */
+			const uint64_t limit = ((uint64_t) 1) << 40;
+			if(header.alphabet_size > limit || header.sequence_count > limit || header.element_count > limit || header.item_count > limit || header.dictionary_size > limit) {
+				return;
+			}
+			
+			uint64_t size = end - begin;
+			uint64_t offset = padded(sizeof(header));
+			
+			dictionary = begin + offset;
+			offset += padded(header.dictionary_size);
+			
+			sequence_offsets = reinterpret_cast<const uint64_t *>(begin + offset);
+			offset += padded(8 * (header.sequence_count + 1));
+			
+			if(itemset()) {
+				element_offsets = reinterpret_cast<const uint64_t *>(begin + offset);
+				offset += padded(8 * (header.element_count + 1));
+			}
+			
+			items = reinterpret_cast<const uint32_t *>(begin + offset);
+			offset += padded(4 * header.item_count);
+			
+			if(labeled()) {
+				labels = reinterpret_cast<const uint8_t *>(begin + offset);
+				offset += padded(header.sequence_count);
+			}
+			
+			valid = offset <= size && (itemset() || header.item_count == header.element_count);
+		}
+		
+		bool good() const {
+			return valid;
+		}
+		
+		bool itemset() const {
+			return header.flags & binary_itemset;
+		}
+		
+		bool labeled() const {
+			return header.flags & binary_labeled;
+		}
+		
+		bool strings() const {
+			return header.flags & binary_strings;
+		}
+		
+		uint64_t size() const {
+			return header.sequence_count;
+		}
+		
+		uint64_t alphabet_size() const {
+			return header.alphabet_size;
+		}
+		
+		uint64_t max_length() const {
+			return header.max_length;
+		}
+		
+		bool label(uint64_t index) const {
+			return labels[index] != 0;
+		}
+		
+		/* item values indexed by item id, numbers are formatted as strings so a
+		 * numeric database also loads with string items */
+		bool load_dictionary(std::vector<std::string> &values) const {
+			if(strings()) {
+				return load_string_dictionary(dictionary, header.alphabet_size, header.dictionary_size, values);
+			}
+			
+			std::vector<int64_t> numbers;
+			if(!load_number_dictionary(numbers)) {
+				return false;
+			}
+			
+			values.resize(numbers.size());
+			for(std::size_t ii=0; ii < numbers.size(); ii++) {
+				std::ostringstream oss;
+				oss << numbers[ii];
+				values[ii] = oss.str();
+			}
+			
+			return true;
+		}
+		
+		/* strings are parsed as numbers, failing on the first one that is not */
+		template <typename T>
+		bool load_dictionary(std::vector<T> &values) const {
+			if(strings()) {
+				std::vector<std::string> names;
+				if(!load_string_dictionary(dictionary, header.alphabet_size, header.dictionary_size, names)) {
+					return false;
+				}
+				
+				values.resize(names.size());
+				for(std::size_t ii=0; ii < names.size(); ii++) {
+					if(!parse_value(names[ii], values[ii])) {
+						return false;
+					}
+				}
+				
+				return true;
+			}
+			
+			std::vector<int64_t> numbers;
+			if(!load_number_dictionary(numbers)) {
+				return false;
+			}
+			
+			values.resize(numbers.size());
+			for(std::size_t ii=0; ii < numbers.size(); ii++) {
+				values[ii] = (T) numbers[ii];
+			}
+			
+			return true;
+		}
+		
+		template <typename T>
+		bool decode(uint64_t index, const std::vector<T> &values, sequence<T> &seq) const {
+			seq.clear();
+			
+			uint64_t first = sequence_offsets[index];
+			uint64_t last = sequence_offsets[index+1];
+			if(itemset() || first > last || last > header.element_count) {
+				return false;
+			}
+			
+			for(uint64_t ii=first; ii < last; ii++) {
+				if(items[ii] >= values.size()) {
+					return false;
+				}
+				
+				seq.push_element(values[items[ii]]);
+			}
+			
+			return true;
+		}
+		
+		template <typename T>
+		bool decode(uint64_t index, const std::vector<T> &values, sequence<ordered_set<T> > &seq) const {
+			seq.clear();
+			
+			uint64_t first = sequence_offsets[index];
+			uint64_t last = sequence_offsets[index+1];
+			if(!itemset() || first > last || last > header.element_count) {
+				return false;
+			}
+			
+			std::vector<T> element;
+			for(uint64_t ii=first; ii < last; ii++) {
+				uint64_t first_item = element_offsets[ii];
+				uint64_t last_item = element_offsets[ii+1];
+				if(first_item > last_item || last_item > header.item_count) {
+					return false;
+				}
+				
+				element.clear();
+				for(uint64_t jj=first_item; jj < last_item; jj++) {
+					if(items[jj] >= values.size() || (jj > first_item && items[jj] <= items[jj-1])) {
+						return false;
+					}
+					
+					element.push_back(values[items[jj]]);
+				}
+				
+				/* the ids follow the stored dictionary, a converted one may order the
+				 * values differently or map two of them to the same value */
+				if(std::adjacent_find(element.begin(), element.end(), std::greater_equal<T>()) != element.end()) {
+					std::sort(element.begin(), element.end());
+					element.erase(std::unique(element.begin(), element.end()), element.end());
+				}
+				
+				seq.push_element(ordered_set<T>());
+				typename std::vector<T>::const_iterator element_iter = element.begin();
+				for(; element_iter != element.end(); ++element_iter) {
+					seq.push_item(*element_iter);
+				}
+			}
+			
+			return true;
+		}
+		
+	private:
+		binary_database_header header;
+		const char *dictionary;
+		const uint64_t *sequence_offsets;
+		const uint64_t *element_offsets;
+		const uint32_t *items;
+		const uint8_t *labels;
+		bool valid;
+		
+		static uint64_t padded(uint64_t size) {
+			return (size + 7) & ~((uint64_t) 7);
+		}
+		
+		bool load_number_dictionary(std::vector<int64_t> &numbers) const {
+			if(strings() || 8 * header.alphabet_size > header.dictionary_size) {
+				return false;
+			}
+			
+			const int64_t *first = reinterpret_cast<const int64_t *>(dictionary);
+			numbers.assign(first, first + header.alphabet_size);
+			
+			return true;
+		}
+		
+		/* a whole string as one value, surrounding whitespace allowed as in the
+		 * text format */
+		template <typename T>
+		static bool parse_value(const std::string &name, T &value) {
+			std::istringstream iss(name);
+			iss >> value;
+			if(iss.fail()) {
+				return false;
+			}
+			
+			while(iss.peek() == ' ' || iss.peek() == '\t' || iss.peek() == '\r' || iss.peek() == '\n') {
+				iss.get();
+			}
+			
+			return iss.peek() == std::char_traits<char>::eof();
+		}
+};
+
+/* decodes every sequence of a binary database into container, labels are dropped */
+template <template <typename, typename> class Container, typename Value, typename Allocator>
+bool read_binary_database(const char *begin, const char *end, Container<sequence<Value>, Allocator> &container) {
+	binary_database database(begin, end);
+	
+	std::vector<typename binary_item<Value>::type> values;
+	if(!database.good() || !database.load_dictionary(values)) {
+		return false;
+	}
+	
+	sequence<Value> seq;
+	Container<sequence<Value>, Allocator> tmp_container;
+	for(uint64_t ii=0; ii < database.size(); ii++) {
+		if(!database.decode(ii, values, seq)) {
+			return false;
+		}
+		
+		tmp_container.insert(tmp_container.end(), sequence<Value>());
+		tmp_container.back().swap(seq);
+	}
+	
+	container.swap(tmp_container);
+	return true;
+}
+
+template <template <typename, typename> class Container, typename Value, typename Allocator>
+bool read_binary_database(const char *begin, const char *end, Container<std::pair<bool,sequence<Value> >, Allocator> &container) {
+	binary_database database(begin, end);
+	
+	std::vector<typename binary_item<Value>::type> values;
+	if(!database.good() || !database.labeled() || !database.load_dictionary(values)) {
+		return false;
+	}
+	
+	sequence<Value> seq;
+	Container<std::pair<bool,sequence<Value> >, Allocator> tmp_container;
+	for(uint64_t ii=0; ii < database.size(); ii++) {
+		if(!database.decode(ii, values, seq)) {
+			return false;
+		}
+		
+		tmp_container.insert(tmp_container.end(), std::pair<bool,sequence<Value> >(database.label(ii), sequence<Value>()));
+		tmp_container.back().second.swap(seq);
+	}
+	
+	container.swap(tmp_container);
+	return true;
+}
+
+template <typename T>
+void binary_items(const sequence<T> &seq, std::set<T> &items) {
+	items.insert(seq.begin(), seq.end());
+}
+
+template <typename T>
+void binary_items(const sequence<ordered_set<T> > &seq, std::set<T> &items) {
+	typename sequence<ordered_set<T> >::const_iterator seq_iter = seq.begin();
+	for(; seq_iter != seq.end(); ++seq_iter) {
+		items.insert(seq_iter->begin(), seq_iter->end());
+	}
+}
+
+template <typename T>
+uint32_t binary_item_id(const std::vector<T> &values, const T &item) {
+	return std::lower_bound(values.begin(), values.end(), item) - values.begin();
+}
+
+/* appends the ids of the items of seq, and for itemsets the element offsets */
+template <typename T>
+void binary_encode(const sequence<T> &seq, const std::vector<T> &values, std::vector<uint64_t> &, std::vector<uint32_t> &items) {
+	typename sequence<T>::const_iterator seq_iter = seq.begin();
+	for(; seq_iter != seq.end(); ++seq_iter) {
+		items.push_back(binary_item_id(values, *seq_iter));
+	}
+}
+
+template <typename T>
+void binary_encode(const sequence<ordered_set<T> > &seq, const std::vector<T> &values, std::vector<uint64_t> &element_offsets, std::vector<uint32_t> &items) {
+	typename sequence<ordered_set<T> >::const_iterator seq_iter = seq.begin();
+	for(; seq_iter != seq.end(); ++seq_iter) {
+		typename ordered_set<T>::const_iterator set_iter = seq_iter->begin();
+		for(; set_iter != seq_iter->end(); ++set_iter) {
+			items.push_back(binary_item_id(values, *set_iter));
+		}
+		
+		element_offsets.push_back(items.size());
+	}
+}
+
+template <typename T>
+bool binary_is_itemset(const sequence<T> &) {
+	return false;
+}
+
+template <typename T>
+bool binary_is_itemset(const sequence<ordered_set<T> > &) {
+	return true;
+}
+
+inline uint32_t binary_dictionary(const std::vector<std::string> &values, std::string &bytes) {
+	std::vector<uint64_t> offsets(1, 0);
+	std::string characters;
+	
+	std::vector<std::string>::const_iterator values_iter = values.begin();
+	for(; values_iter != values.end(); ++values_iter) {
+		characters += *values_iter;
+		offsets.push_back(characters.size());
+	}
+	
+	bytes.assign(reinterpret_cast<const char *>(&offsets[0]), 8 * offsets.size());
+	bytes += characters;
+	
+	return binary_strings;
+}
+
+template <typename T>
+uint32_t binary_dictionary(const std::vector<T> &values, std::string &bytes) {
+	std::vector<int64_t> numbers(values.begin(), values.end());
+	
+	bytes.clear();
+	if(!numbers.empty()) {
+		bytes.assign(reinterpret_cast<const char *>(&numbers[0]), 8 * numbers.size());
+	}
+	
+	return 0;
+}
+
+template <typename T>
+void write_binary_section(std::ostream &output, const T *data, uint64_t count) {
+	static const char padding[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+	
+	uint64_t size = sizeof(T) * count;
+	if(size > 0) {
+		output.write(reinterpret_cast<const char *>(data), size);
+	}
+	output.write(padding, (8 - size % 8) % 8);
+}
+
+/* writes database in the binary format, with labels when labels is given */
+template <typename Value>
+void write_binary_database(std::ostream &output, const std::vector<const sequence<Value> *> &database, const std::vector<uint8_t> *labels) {
+	typedef typename binary_item<Value>::type item_type;
+	
+	std::set<item_type> item_set;
+	typename std::vector<const sequence<Value> *>::const_iterator database_iter = database.begin();
+	for(; database_iter != database.end(); ++database_iter) {
+		binary_items(**database_iter, item_set);
+	}
+	std::vector<item_type> values(item_set.begin(), item_set.end());
+	
+	std::vector<uint64_t> sequence_offsets(1, 0);
+	std::vector<uint64_t> element_offsets(1, 0);
+	std::vector<uint32_t> items;
+	uint64_t max_length = 0;
+	for(database_iter = database.begin(); database_iter != database.end(); ++database_iter) {
+		binary_encode(**database_iter, values, element_offsets, items);
+		
+		sequence_offsets.push_back(sequence_offsets.back() + (*database_iter)->length());
+		max_length = std::max<uint64_t>(max_length, (*database_iter)->length());
+	}
+	
+	std::string dictionary;
+	
+	binary_database_header header;
+	std::memcpy(header.magic, binary_database_magic, sizeof(binary_database_magic));
+	header.version = binary_database_version;
+	header.flags = binary_dictionary(values, dictionary);
+	header.alphabet_size = values.size();
+	header.sequence_count = database.size();
+	header.max_length = max_length;
+	header.element_count = sequence_offsets.back();
+	header.item_count = items.size();
+	header.dictionary_size = dictionary.size();
+	
+	bool itemset = binary_is_itemset(sequence<Value>());
+	if(itemset) {
+		header.flags |= binary_itemset;
+	}
+	if(labels) {
+		header.flags |= binary_labeled;
+	}
+	
+	write_binary_section(output, &header, 1);
+	write_binary_section(output, dictionary.data(), dictionary.size());
+	write_binary_section(output, &sequence_offsets[0], sequence_offsets.size());
+	if(itemset) {
+		write_binary_section(output, &element_offsets[0], element_offsets.size());
+	}
+	write_binary_section(output, items.empty() ? NULL : &items[0], items.size());
+	if(labels) {
+		write_binary_section(output, labels->empty() ? NULL : &(*labels)[0], labels->size());
+	}
+}
+
+template <typename Value>
+void write_binary_database(std::ostream &output, const std::vector<sequence<Value> > &database) {
+	std::vector<const sequence<Value> *> ptr_database;
+	
+	typename std::vector<sequence<Value> >::const_iterator database_iter = database.begin();
+	for(; database_iter != database.end(); ++database_iter) {
+		ptr_database.push_back(&*database_iter);
+	}
+	
+	write_binary_database(output, ptr_database, (const std::vector<uint8_t> *) NULL);
+}
+
+template <typename Value>
+void write_binary_database(std::ostream &output, const std::vector<std::pair<bool,sequence<Value> > > &database) {
+	std::vector<const sequence<Value> *> ptr_database;
+	std::vector<uint8_t> labels;
+	
+	typename std::vector<std::pair<bool,sequence<Value> > >::const_iterator database_iter = database.begin();
+	for(; database_iter != database.end(); ++database_iter) {
+		ptr_database.push_back(&database_iter->second);
+		labels.push_back(database_iter->first);
+	}
+	
+	write_binary_database(output, ptr_database, &labels);
+}
+
+#endif
@@ -0,0 +1,6 @@
+#include "pattern_mining.hh"
+#include "bitmap_miner.hh"
+
+int main(int argc, char *argv[]) {
+	return run<bitmap_miner>(argc, argv);
+}
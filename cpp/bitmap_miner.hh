@@ -0,0 +1,573 @@
+#ifndef _BITMAP_MINER_HH_
+#define _BITMAP_MINER_HH_
+
+#include <iostream>
+#include <sstream>
+
+#include <list>
+#include <map>
+#include <vector>
+
+#include <algorithm>
+#include <iterator>
+
+#include <stdint.h>
+
+/* the word kernels pick AVX2 or SSE2 at run time on x86-64 */
+#if defined(__GNUC__) && defined(__x86_64__)
+#define BITMAP_MINER_SIMD
+#include <immintrin.h>
+#endif
+
+#include "ordered_set.hh"
+#include "sequence.hh"
+#include "flat_database.hh"
+#include "sequential_pattern_miner.hh"
+
+/* vertical bitmap (SPAM style) miner
+ *
+ * every frequent item gets one bitmap with as many 64 bit words per sequence as
+ * the sequence needs, where bit i is set when the item occurs in the i-th
+ * itemset of the sequence. as in SPAM the sequences are bucketed by their
+ * number of words, so a few long sequences do not widen the short ones.
+ *
+ * a pattern is represented by the bitmap of the positions where it can end. an
+ * I-step is a bitwise and with the item bitmap, an S-step first sets every bit
+ * after the lowest set bit of each sequence and then ands with the item bitmap.
+ * the support is the number of sequences with a nonzero section.
+ *
+ * on x86-64 the steps process four words at a time with AVX2 when the processor
+ * has it and two at a time with SSE2 otherwise, without compiler flags. */
+template <typename Value1, typename Value2>
+class bitmap_miner : public sequential_pattern_miner<Value1,Value2> {
+	public:
+		using sequential_pattern_miner<Value1,Value2>::mine;
+		
+		virtual bool supports_cooccurrence_pruning() const {
+			return false;
+		}
+		
+		/* the bitmaps are joined depth first without tasks */
+		virtual bool supports_threads() const {
+			return false;
+		}
+		
+		#ifndef NDEBUG
+		using sequential_pattern_miner<Value1,Value2>::update_graph;
+		#endif
+		
+	protected:
+		typedef std::vector<uint64_t> bitmap;
+		
+		virtual void mine_patterns(std::vector<const sequence<Value1> *> &database, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<Value1> &return_patterns, pattern_sink<Value1> &) const {
+			#ifndef NDEBUG
+			std::cerr << __FILE__ << ":" << __LINE__ << std::endl;
+			#endif
+			
+			mine_bitmap_patterns(database, items, min_support, return_patterns);
+		}
+		
+		virtual void mine_patterns(std::vector<const sequence_view<Value1> *> &database, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<Value1> &return_patterns, pattern_sink<Value1> &) const {
+			#ifndef NDEBUG
+			std::cerr << __FILE__ << ":" << __LINE__ << std::endl;
+			#endif
+			
+			mine_bitmap_patterns(database, items, min_support, return_patterns);
+		}
+		
+	private:
+		/* sequences of the same number of words are stored together, shortest
+		 * first, in groups of [begin, end) words */
+		struct bitmap_group {
+			unsigned int words;
+			bitmap::size_type begin;
+			bitmap::size_type end;
+		};
+		
+		typedef std::vector<bitmap_group> bitmap_layout;
+		
+		/* groups the sequences of the given lengths by their number of words and
+		 * sets offsets to the first word of every sequence, sequences without
+		 * frequent items take no words */
+		static bitmap::size_type layout_sequences(const std::vector<unsigned int> &lengths, bitmap_layout &layout, std::vector<bitmap::size_type> &offsets) {
+			std::vector<unsigned int> sequence_words(lengths.size());
+			std::vector<unsigned int> group_sizes;
+			for(unsigned int ii=0; ii < lengths.size(); ii++) {
+				sequence_words[ii] = (lengths[ii] + 63) / 64;
+				if(sequence_words[ii] >= group_sizes.size()) {
+					group_sizes.resize(sequence_words[ii] + 1, 0);
+				}
+				group_sizes[sequence_words[ii]]++;
+			}
+			
+			std::vector<bitmap::size_type> next_offsets(group_sizes.size(), 0);
+			bitmap::size_type size = 0;
+			for(unsigned int words=1; words < group_sizes.size(); words++) {
+				if(group_sizes[words] > 0) {
+					bitmap_group group;
+					group.words = words;
+					group.begin = size;
+					group.end = size + (bitmap::size_type) group_sizes[words] * words;
+					layout.push_back(group);
+					
+					next_offsets[words] = size;
+					size = group.end;
+				}
+			}
+			
+			offsets.resize(lengths.size());
+			for(unsigned int ii=0; ii < lengths.size(); ii++) {
+				offsets[ii] = next_offsets[sequence_words[ii]];
+				next_offsets[sequence_words[ii]] += sequence_words[ii];
+			}
+			
+			return size;
+		}
+		
+		/* number of sequences with at least one bit set in [begin, end) of a
+		 * group of words per sequence */
+		static unsigned int support(const uint64_t *bits, bitmap::size_type begin, bitmap::size_type end, unsigned int words) {
+			unsigned int count = 0;
+			
+			for(bitmap::size_type ii=begin; ii < end; ii+=words) {
+				for(unsigned int jj=0; jj < words; jj++) {
+					if(bits[ii+jj] != 0) {
+						count++;
+						break;
+					}
+				}
+			}
+			
+			return count;
+		}
+		
+		static unsigned int support(const bitmap &bits, const bitmap_layout &layout) {
+			unsigned int count = 0;
+			
+			typename bitmap_layout::const_iterator layout_iter = layout.begin();
+			for(; layout_iter != layout.end(); ++layout_iter) {
+				count += support(&bits[0], layout_iter->begin, layout_iter->end, layout_iter->words);
+			}
+			
+			return count;
+		}
+		
+		#ifdef BITMAP_MINER_SIMD
+		static bool has_avx2() {
+			static const bool avx2 = __builtin_cpu_supports("avx2");
+			return avx2;
+		}
+		
+		/* number of bits set in a four bit movemask, __builtin_popcount is a
+		 * library call without -mpopcnt */
+		static unsigned int mask_bits(int mask) {
+			mask = (mask & 5) + ((mask >> 1) & 5);
+			return (mask & 3) + (mask >> 2);
+		}
+		
+		/* the kernels below advance ii over the words they process and leave
+		 * the remaining words to the scalar loop of the caller */
+		__attribute__((target("avx2")))
+		static unsigned int and_words_avx2(const uint64_t *prefix, const uint64_t *item, uint64_t *result, bitmap::size_type &ii, bitmap::size_type end) {
+			unsigned int count = 0;
+			
+			const __m256i zero = _mm256_setzero_si256();
+			for(; ii+4 <= end; ii+=4) {
+				__m256i bits = _mm256_and_si256(_mm256_loadu_si256((const __m256i *) &prefix[ii]), _mm256_loadu_si256((const __m256i *) &item[ii]));
+				_mm256_storeu_si256((__m256i *) &result[ii], bits);
+				
+				count += 4 - mask_bits(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(bits, zero))));
+			}
+			
+			return count;
+		}
+		
+		__attribute__((target("avx2")))
+		static unsigned int s_step_words_avx2(const uint64_t *prefix, const uint64_t *item, uint64_t *result, bitmap::size_type &ii, bitmap::size_type end) {
+			unsigned int count = 0;
+			
+			const __m256i zero = _mm256_setzero_si256();
+			const __m256i ones = _mm256_cmpeq_epi64(zero, zero);
+			for(; ii+4 <= end; ii+=4) {
+				__m256i bits = _mm256_loadu_si256((const __m256i *) &prefix[ii]);
+				__m256i lowest = _mm256_and_si256(bits, _mm256_sub_epi64(zero, bits));
+				__m256i after = _mm256_andnot_si256(_mm256_or_si256(lowest, _mm256_add_epi64(lowest, ones)), ones);
+				
+				bits = _mm256_and_si256(after, _mm256_loadu_si256((const __m256i *) &item[ii]));
+				_mm256_storeu_si256((__m256i *) &result[ii], bits);
+				
+				count += 4 - mask_bits(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(bits, zero))));
+			}
+			
+			return count;
+		}
+		
+		/* SSE2 has no 64 bit compare, a word is zero when both of its 32 bit halves are */
+		static unsigned int nonzero_words_sse2(__m128i bits) {
+			__m128i zero_halves = _mm_cmpeq_epi32(bits, _mm_setzero_si128());
+			__m128i zero_words = _mm_and_si128(zero_halves, _mm_shuffle_epi32(zero_halves, _MM_SHUFFLE(2, 3, 0, 1)));
+			int mask = _mm_movemask_pd(_mm_castsi128_pd(zero_words));
+			return 2 - (mask & 1) - (mask >> 1);
+		}
+		
+		static unsigned int and_words_sse2(const uint64_t *prefix, const uint64_t *item, uint64_t *result, bitmap::size_type &ii, bitmap::size_type end) {
+			unsigned int count = 0;
+			
+			for(; ii+2 <= end; ii+=2) {
+				__m128i bits = _mm_and_si128(_mm_loadu_si128((const __m128i *) &prefix[ii]), _mm_loadu_si128((const __m128i *) &item[ii]));
+				_mm_storeu_si128((__m128i *) &result[ii], bits);
+				
+				count += nonzero_words_sse2(bits);
+			}
+			
+			return count;
+		}
+		
+		static unsigned int s_step_words_sse2(const uint64_t *prefix, const uint64_t *item, uint64_t *result, bitmap::size_type &ii, bitmap::size_type end) {
+			unsigned int count = 0;
+			
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i ones = _mm_cmpeq_epi32(zero, zero);
+			for(; ii+2 <= end; ii+=2) {
+				__m128i bits = _mm_loadu_si128((const __m128i *) &prefix[ii]);
+				__m128i lowest = _mm_and_si128(bits, _mm_sub_epi64(zero, bits));
+				__m128i after = _mm_andnot_si128(_mm_or_si128(lowest, _mm_add_epi64(lowest, ones)), ones);
+				
+				bits = _mm_and_si128(after, _mm_loadu_si128((const __m128i *) &item[ii]));
+				_mm_storeu_si128((__m128i *) &result[ii], bits);
+				
+				count += nonzero_words_sse2(bits);
+			}
+			
+			return count;
+		}
+		#endif
+		
+		/* result = prefix & item over [begin, end), returning the number of nonzero words */
+		static unsigned int and_words(const uint64_t *prefix, const uint64_t *item, uint64_t *result, bitmap::size_type begin, bitmap::size_type end) {
+			unsigned int count = 0;
+			
+			bitmap::size_type ii = begin;
+			
+			#ifdef BITMAP_MINER_SIMD
+			if(has_avx2()) {
+				count += and_words_avx2(prefix, item, result, ii, end);
+			}
+			else {
+				count += and_words_sse2(prefix, item, result, ii, end);
+			}
+			#endif
+			
+			for(; ii < end; ii++) {
+				result[ii] = prefix[ii] & item[ii];
+				if(result[ii] != 0) {
+					count++;
+				}
+			}
+			
+			return count;
+		}
+		
+		/* the S-step of sequences of one word over [begin, end), returning the
+		 * number of nonzero words */
+		static unsigned int s_step_words(const uint64_t *prefix, const uint64_t *item, uint64_t *result, bitmap::size_type begin, bitmap::size_type end) {
+			unsigned int count = 0;
+			
+			bitmap::size_type ii = begin;
+			
+			#ifdef BITMAP_MINER_SIMD
+			if(has_avx2()) {
+				count += s_step_words_avx2(prefix, item, result, ii, end);
+			}
+			else {
+				count += s_step_words_sse2(prefix, item, result, ii, end);
+			}
+			#endif
+			
+			for(; ii < end; ii++) {
+				uint64_t lowest = prefix[ii] & (~prefix[ii] + 1);
+				result[ii] = ~(lowest | (lowest - 1)) & item[ii];
+				if(result[ii] != 0) {
+					count++;
+				}
+			}
+			
+			return count;
+		}
+		
+		static unsigned int i_step(const bitmap &prefix, const bitmap &item, const bitmap_layout &layout, bitmap &result) {
+			result.resize(prefix.size());
+			
+			unsigned int count = 0;
+			
+			typename bitmap_layout::const_iterator layout_iter = layout.begin();
+			for(; layout_iter != layout.end(); ++layout_iter) {
+				unsigned int nonzero_words = and_words(&prefix[0], &item[0], &result[0], layout_iter->begin, layout_iter->end);
+				if(layout_iter->words == 1) {
+					count += nonzero_words;
+				}
+				else if(nonzero_words > 0) {
+					count += support(&result[0], layout_iter->begin, layout_iter->end, layout_iter->words);
+				}
+			}
+			
+			return count;
+		}
+		
+		static unsigned int s_step(const bitmap &prefix, const bitmap &item, const bitmap_layout &layout, bitmap &result) {
+			result.resize(prefix.size());
+			
+			unsigned int count = 0;
+			
+			typename bitmap_layout::const_iterator layout_iter = layout.begin();
+			for(; layout_iter != layout.end(); ++layout_iter) {
+				unsigned int words = layout_iter->words;
+				if(words == 1) {
+					count += s_step_words(&prefix[0], &item[0], &result[0], layout_iter->begin, layout_iter->end);
+					continue;
+				}
+				
+				for(bitmap::size_type ii=layout_iter->begin; ii < layout_iter->end; ii+=words) {
+					unsigned int jj = 0;
+					for(; jj < words && prefix[ii+jj] == 0; jj++) {
+						result[ii+jj] = 0;
+					}
+					
+					if(jj < words) {
+						uint64_t lowest = prefix[ii+jj] & (~prefix[ii+jj] + 1);
+						result[ii+jj] = ~(lowest | (lowest - 1)) & item[ii+jj];
+						bool nonzero = result[ii+jj] != 0;
+						
+						for(jj++; jj < words; jj++) {
+							result[ii+jj] = item[ii+jj];
+							nonzero = nonzero || result[ii+jj] != 0;
+						}
+						
+						if(nonzero) {
+							count++;
+						}
+					}
+				}
+			}
+			
+			return count;
+		}
+		
+		static void set_bit(bitmap &bits, bitmap::size_type offset, unsigned int position) {
+			bits[offset + position / 64] |= ((uint64_t) 1) << (position % 64);
+		}
+		
+		template <typename Sequence>
+		void mine_bitmap_patterns(std::vector<const Sequence *> &database, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<Value2> &return_patterns) const {
+			flat_database<unsigned int> index_database;
+			sequence<unsigned int> index_seq;
+			std::vector<unsigned int> lengths;
+			
+			typename std::vector<const Sequence *>::iterator database_iter = database.begin();
+			for(; database_iter != database.end(); ++database_iter) {
+				index_seq.clear();
+				
+				typename Sequence::const_iterator seq_iter = (*database_iter)->begin();
+				for(; seq_iter != (*database_iter)->end(); ++seq_iter) {
+					unsigned int index = item_index(items, *seq_iter);
+					if(index < items.size()) {
+						index_seq.push_element(index);
+					}
+				}
+				
+				lengths.push_back(index_seq.length());
+				index_database.push_back(index_seq);
+			}
+			
+			bitmap_layout layout;
+			std::vector<bitmap::size_type> offsets;
+			bitmap::size_type size = layout_sequences(lengths, layout, offsets);
+			
+			std::vector<bitmap> bitmaps(items.size(), bitmap(size, 0));
+			for(unsigned int ii=0; ii < index_database.size(); ii++) {
+				sequence_view<unsigned int> index_view = index_database[ii];
+				for(unsigned int jj=0; jj < index_view.length(); jj++) {
+					set_bit(bitmaps[index_view[jj]], offsets[ii], jj);
+				}
+			}
+			
+			index_database.clear();
+			
+			std::vector<unsigned int> candidates;
+			for(unsigned int ii=0; ii < items.size(); ii++) {
+				if(support(bitmaps[ii], layout) >= min_support) {
+					candidates.push_back(ii);
+				}
+			}
+			
+			sequence<Value2> seq;
+			std::vector<unsigned int>::iterator candidates_iter = candidates.begin();
+			for(; candidates_iter != candidates.end(); ++candidates_iter) {
+				seq.push_element(items[*candidates_iter]);
+				
+				#ifndef NDEBUG
+				update_graph(seq, items);
+				#endif
+				
+				mine_patterns(bitmaps, layout, bitmaps[*candidates_iter], support(bitmaps[*candidates_iter], layout), seq, candidates, items, min_support, return_patterns);
+				
+				seq.pop_element();
+			}
+		}
+		
+		template <typename Sequence>
+		void mine_bitmap_patterns(std::vector<const Sequence *> &database, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<ordered_set<Value2> > &return_patterns) const {
+			typedef typename std::iterator_traits<typename Sequence::const_iterator>::value_type set_type;
+			
+			/* elements without frequent items still take a position */
+			std::vector<unsigned int> lengths;
+			
+			typename std::vector<const Sequence *>::iterator database_iter = database.begin();
+			for(; database_iter != database.end(); ++database_iter) {
+				lengths.push_back((*database_iter)->length());
+			}
+			
+			bitmap_layout layout;
+			std::vector<bitmap::size_type> offsets;
+			bitmap::size_type size = layout_sequences(lengths, layout, offsets);
+			
+			std::vector<bitmap> bitmaps(items.size(), bitmap(size, 0));
+			for(unsigned int ii=0; ii < database.size(); ii++) {
+				unsigned int position = 0;
+				
+				typename Sequence::const_iterator seq_iter = database[ii]->begin();
+				for(; seq_iter != database[ii]->end(); ++seq_iter, position++) {
+					const set_type &tmp_set = *seq_iter;
+					
+					typename set_type::const_iterator tmp_set_iter = tmp_set.begin();
+					for(; tmp_set_iter != tmp_set.end(); ++tmp_set_iter) {
+						unsigned int index = item_index(items, *tmp_set_iter);
+						if(index < items.size()) {
+							set_bit(bitmaps[index], offsets[ii], position);
+						}
+					}
+				}
+			}
+			
+			std::vector<unsigned int> candidates;
+			for(unsigned int ii=0; ii < items.size(); ii++) {
+				if(support(bitmaps[ii], layout) >= min_support) {
+					candidates.push_back(ii);
+				}
+			}
+			
+			sequence<ordered_set<Value2> > seq;
+			std::vector<unsigned int>::iterator candidates_iter = candidates.begin();
+			for(; candidates_iter != candidates.end(); ++candidates_iter) {
+				seq.push_element(ordered_set<Value2>());
+				seq.push_item(items[*candidates_iter]);
+				
+				#ifndef NDEBUG
+				update_graph(seq, items);
+				#endif
+				
+				std::vector<unsigned int> item_candidates(candidates_iter+1, candidates.end());
+				mine_patterns(bitmaps, layout, bitmaps[*candidates_iter], support(bitmaps[*candidates_iter], layout), seq, item_candidates, candidates, items, min_support, return_patterns);
+				
+				seq.pop_element();
+			}
+		}
+		
+		void mine_patterns(const std::vector<bitmap> &bitmaps, const bitmap_layout &layout, const bitmap &prefix, unsigned int prefix_support, sequence<Value2> &seq, const std::vector<unsigned int> &candidates, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<Value2> &return_patterns) const {
+			maintain_and_test(seq, prefix_support, return_patterns);
+			
+			std::vector<bitmap> extensions;
+			std::vector<unsigned int> extension_supports;
+			std::vector<unsigned int> frequent_candidates;
+			
+			bitmap extension;
+			std::vector<unsigned int>::const_iterator candidates_iter = candidates.begin();
+			for(; candidates_iter != candidates.end(); ++candidates_iter) {
+				unsigned int extension_support = s_step(prefix, bitmaps[*candidates_iter], layout, extension);
+				if(extension_support >= min_support) {
+					extensions.push_back(bitmap());
+					extensions.back().swap(extension);
+					extension_supports.push_back(extension_support);
+					frequent_candidates.push_back(*candidates_iter);
+				}
+			}
+			
+			for(unsigned int ii=0; ii < frequent_candidates.size(); ii++) {
+				seq.push_element(items[frequent_candidates[ii]]);
+				
+				#ifndef NDEBUG
+				update_graph(seq, items);
+				#endif
+				
+				mine_patterns(bitmaps, layout, extensions[ii], extension_supports[ii], seq, frequent_candidates, items, min_support, return_patterns);
+				
+				seq.pop_element();
+			}
+		}
+		
+		/* item_candidates extend the last itemset of seq, element_candidates start a new one */
+		void mine_patterns(const std::vector<bitmap> &bitmaps, const bitmap_layout &layout, const bitmap &prefix, unsigned int prefix_support, sequence<ordered_set<Value2> > &seq, const std::vector<unsigned int> &item_candidates, const std::vector<unsigned int> &element_candidates, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<ordered_set<Value2> > &return_patterns) const {
+			maintain_and_test(seq, prefix_support, return_patterns);
+			
+			bitmap extension;
+			
+			std::vector<bitmap> item_extensions;
+			std::vector<unsigned int> item_supports;
+			std::vector<unsigned int> frequent_items;
+			
+			std::vector<unsigned int>::const_iterator candidates_iter = item_candidates.begin();
+			for(; candidates_iter != item_candidates.end(); ++candidates_iter) {
+				unsigned int extension_support = i_step(prefix, bitmaps[*candidates_iter], layout, extension);
+				if(extension_support >= min_support) {
+					item_extensions.push_back(bitmap());
+					item_extensions.back().swap(extension);
+					item_supports.push_back(extension_support);
+					frequent_items.push_back(*candidates_iter);
+				}
+			}
+			
+			std::vector<bitmap> element_extensions;
+			std::vector<unsigned int> element_supports;
+			std::vector<unsigned int> frequent_elements;
+			
+			candidates_iter = element_candidates.begin();
+			for(; candidates_iter != element_candidates.end(); ++candidates_iter) {
+				unsigned int extension_support = s_step(prefix, bitmaps[*candidates_iter], layout, extension);
+				if(extension_support >= min_support) {
+					element_extensions.push_back(bitmap());
+					element_extensions.back().swap(extension);
+					element_supports.push_back(extension_support);
+					frequent_elements.push_back(*candidates_iter);
+				}
+			}
+			
+			for(unsigned int ii=0; ii < frequent_items.size(); ii++) {
+				seq.push_item(items[frequent_items[ii]]);
+				
+				#ifndef NDEBUG
+				update_graph(seq, items);
+				#endif
+				
+				std::vector<unsigned int> next_item_candidates(frequent_items.begin()+ii+1, frequent_items.end());
+				mine_patterns(bitmaps, layout, item_extensions[ii], item_supports[ii], seq, next_item_candidates, frequent_elements, items, min_support, return_patterns);
+				
+				seq.pop_item();
+			}
+			
+			for(unsigned int ii=0; ii < frequent_elements.size(); ii++) {
+				seq.push_element(ordered_set<Value2>());
+				seq.push_item(items[frequent_elements[ii]]);
+				
+				#ifndef NDEBUG
+				update_graph(seq, items);
+				#endif
+				
+				std::vector<unsigned int> next_item_candidates(frequent_elements.begin()+ii+1, frequent_elements.end());
+				mine_patterns(bitmaps, layout, element_extensions[ii], element_supports[ii], seq, next_item_candidates, frequent_elements, items, min_support, return_patterns);
+				
+				seq.pop_element();
+			}
+		}
+};
+
+#endif
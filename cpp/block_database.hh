@@ -0,0 +1,319 @@
+#ifndef _BLOCK_DATABASE_HH_
+#define _BLOCK_DATABASE_HH_
+
+#include <ostream>
+#include <sstream>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <algorithm>
+
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+
+#include <zlib.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "sequence.hh"
+#include "sequence_parser.hh"
+
+/* block compressed sequence database
+ *
+ * the text database cut into blocks of whole sequences, each deflated on its
+ * own, so blocks can be inflated in parallel and a range of sequences can be
+ * loaded without touching the blocks around it:
+ *   header   magic, version
+ *   blocks   zlib streams of text sequences, one per line
+ *   index    per block the file offset, compressed and raw size, and the
+ *            index of its first sequence, aligned to 8 bytes
+ *   trailer  block count, sequence count, index offset, magic
+ *
+ * all fields are in native byte order, the version field doubles as a byte
+ * order check. */
+static const char block_database_magic[8] = { '\x89', 'S', 'E', 'Q', 'B', 'Z', '\r', '\n' };
+static const uint32_t block_database_version = 1;
+
+struct block_database_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t flags;
+};
+
+struct block_database_entry {
+	uint64_t offset;
+	uint64_t compressed_size;
+	uint64_t raw_size;
+	uint64_t first_sequence;
+};
+
+struct block_database_trailer {
+	uint64_t block_count;
+	uint64_t sequence_count;
+	uint64_t index_offset;
+	char magic[8];
+};
+
+inline bool is_block_database(const char *begin, const char *end) {
+	return end - begin >= (std::ptrdiff_t) sizeof(block_database_magic) && std::memcmp(begin, block_database_magic, sizeof(block_database_magic)) == 0;
+}
+
+/* view of a block compressed database held in memory, blocks are inflated on demand */
+class block_database {
+	public:
+		block_database(const char *begin, const char *end) : begin(begin), index(NULL), trailer(), valid(false) {
+			uint64_t size = end - begin;
+			if(!is_block_database(begin, end) || size < sizeof(block_database_header) + sizeof(block_database_trailer)) {
+				return;
+			}
+			
+			block_database_header header;
+			std::memcpy(&header, begin, sizeof(header));
+			std::memcpy(&trailer, end - sizeof(trailer), sizeof(trailer));
+			if(header.version != block_database_version || std::memcmp(trailer.magic, block_database_magic, sizeof(block_database_magic)) != 0) {
+				return;
+			}
+			
+			uint64_t index_end = size - sizeof(trailer);
+			if(trailer.index_offset < sizeof(header) || trailer.index_offset % 8 != 0 || trailer.index_offset > index_end || trailer.block_count != (index_end - trailer.index_offset) / sizeof(block_database_entry)) {
+				return;
+			}
+			
+			index = reinterpret_cast<const block_database_entry *>(begin + trailer.index_offset);
+			
+			uint64_t first_sequence = 0;
+			for(uint64_t ii=0; ii < trailer.block_count; ii++) {
+				if(index[ii].offset < sizeof(header) || index[ii].offset > trailer.index_offset || index[ii].compressed_size > trailer.index_offset - index[ii].offset || index[ii].first_sequence != first_sequence) {
+					return;
+				}
+				
+				first_sequence = (ii+1 < trailer.block_count) ? index[ii+1].first_sequence : trailer.sequence_count;
+				if(first_sequence < index[ii].first_sequence) {
+					return;
+				}
+			}
+			
+			valid = first_sequence == trailer.sequence_count;
+		}
+		
+		bool good() const {
+			return valid;
+		}
+		
+		uint64_t size() const {
+			return trailer.sequence_count;
+		}
+		
+		uint64_t block_count() const {
+			return trailer.block_count;
+		}
+		
+		/* block holding sequence index */
+		uint64_t block_of(uint64_t sequence_index) const {
+			uint64_t lower = 0, upper = trailer.block_count;
+			while(upper - lower > 1) {
+				uint64_t middle = lower + (upper - lower) / 2;
+				if(index[middle].first_sequence <= sequence_index) {
+					lower = middle;
+				}
+				else {
+					upper = middle;
+				}
+			}
+			
+			return lower;
+		}
+		
+		uint64_t first_sequence(uint64_t block) const {
+			return block < trailer.block_count ? index[block].first_sequence : trailer.sequence_count;
+		}
+		
+		/* inflates a block into buffer */
+		bool inflate_block(uint64_t block, std::vector<char> &buffer) const {
+			const block_database_entry &entry = index[block];
+			
+			buffer.resize(entry.raw_size);
+			if(entry.raw_size == 0) {
+				return entry.compressed_size == 0;
+			}
+			
+			uLongf size = entry.raw_size;
+			return uncompress(reinterpret_cast<Bytef *>(&buffer[0]), &size, reinterpret_cast<const Bytef *>(begin + entry.offset), entry.compressed_size) == Z_OK && size == entry.raw_size;
+		}
+		
+		/* inflates and parses a block, checking it holds as many sequences as the index says */
+		template <typename Container>
+		bool read_block(uint64_t block, Container &container) const {
+			std::vector<char> buffer;
+			if(!inflate_block(block, buffer)) {
+				return false;
+			}
+			
+			const char *buffer_begin = buffer.empty() ? NULL : &buffer[0];
+			return parse_sequences(buffer_begin, buffer_begin + buffer.size(), container) && container.size() == first_sequence(block+1) - first_sequence(block);
+		}
+		
+	private:
+		const char *begin;
+		const block_database_entry *index;
+		block_database_trailer trailer;
+		bool valid;
+};
+
+/* decodes the sequences [first, last) of a block compressed database into
+ * container, inflating the blocks they span in parallel when built with OpenMP */
+template <typename Container>
+bool read_block_database(const char *begin, const char *end, uint64_t first, uint64_t last, Container &container) {
+	block_database database(begin, end);
+	if(!database.good() || first > last || last > database.size()) {
+		return false;
+	}
+	
+	Container tmp_container;
+	if(first == last) {
+		container.swap(tmp_container);
+		return true;
+	}
+	
+	uint64_t first_block = database.block_of(first);
+	uint64_t last_block = database.block_of(last-1) + 1;
+	
+	std::vector<Container> parts(last_block - first_block);
+	std::vector<char> parsed(last_block - first_block);
+	
+	#ifdef _OPENMP
+	#pragma omp parallel for schedule(dynamic)
+	#endif
+	for(int ii=0; ii < (int) parts.size(); ii++) {
+		parsed[ii] = database.read_block(first_block + ii, parts[ii]);
+	}
+	
+	for(uint64_t ii=0; ii < parts.size(); ii++) {
+		if(!parsed[ii]) {
+			return false;
+		}
+	}
+	
+	reserve_sequences(tmp_container, last - first);
+	for(uint64_t ii=0; ii < parts.size(); ii++) {
+		uint64_t sequence_index = database.first_sequence(first_block + ii);
+		
+		typename Container::iterator parts_iter = parts[ii].begin();
+		for(; parts_iter != parts[ii].end(); ++parts_iter, ++sequence_index) {
+			if(sequence_index >= first && sequence_index < last) {
+				tmp_container.insert(tmp_container.end(), typename Container::value_type());
+				swap_sequences(tmp_container.back(), *parts_iter);
+			}
+		}
+		
+		Container().swap(parts[ii]);
+	}
+	
+	container.swap(tmp_container);
+	return true;
+}
+
+template <typename Container>
+bool read_block_database(const char *begin, const char *end, Container &container) {
+	block_database database(begin, end);
+	
+	return database.good() && read_block_database(begin, end, 0, database.size(), container);
+}
+
+template <typename T>
+void write_block_text(std::ostream &output, const sequence<T> &seq) {
+	output << seq << "\n";
+}
+
+template <typename T>
+void write_block_text(std::ostream &output, const std::pair<bool,sequence<T> > &labeled_seq) {
+	output << labeled_seq.second << " " << labeled_seq.first << "\n";
+}
+
+/* deflates the text of a block and appends it to output, recording it in index */
+inline bool write_block(std::ostream &output, const std::string &text, uint64_t first_sequence, uint64_t &offset, std::vector<block_database_entry> &index) {
+	block_database_entry entry;
+	entry.offset = offset;
+	entry.raw_size = text.size();
+	entry.first_sequence = first_sequence;
+	entry.compressed_size = 0;
+	
+	if(!text.empty()) {
+		std::vector<char> compressed(compressBound(text.size()));
+		
+		uLongf size = compressed.size();
+		if(compress2(reinterpret_cast<Bytef *>(&compressed[0]), &size, reinterpret_cast<const Bytef *>(text.data()), text.size(), Z_DEFAULT_COMPRESSION) != Z_OK) {
+			return false;
+		}
+		
+		output.write(&compressed[0], size);
+		entry.compressed_size = size;
+	}
+	
+	offset += entry.compressed_size;
+	index.push_back(entry);
+	
+	return true;
+}
+
+/* writes database in the block compressed format, cutting a block once its
+ * text reaches block_size bytes */
+template <typename Container>
+bool write_block_database(std::ostream &output, const Container &database, std::size_t block_size=1 << 20) {
+	block_database_header header;
+	std::memcpy(header.magic, block_database_magic, sizeof(block_database_magic));
+	header.version = block_database_version;
+	header.flags = 0;
+	output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	
+	uint64_t offset = sizeof(header);
+	std::vector<block_database_entry> index;
+	
+	std::ostringstream text;
+	uint64_t sequence_count = 0;
+	uint64_t first_sequence = 0;
+	
+	typename Container::const_iterator database_iter = database.begin();
+	for(; database_iter != database.end(); ++database_iter) {
+		write_block_text(text, *database_iter);
+		sequence_count++;
+		
+		if((std::size_t) text.tellp() >= block_size) {
+			if(!write_block(output, text.str(), first_sequence, offset, index)) {
+				return false;
+			}
+			
+			text.str("");
+			first_sequence = sequence_count;
+		}
+	}
+	
+	if(sequence_count > first_sequence && !write_block(output, text.str(), first_sequence, offset, index)) {
+		return false;
+	}
+	
+	/* the index is aligned to 8 bytes so it can be read in place */
+	static const char padding[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+	output.write(padding, (8 - offset % 8) % 8);
+	offset += (8 - offset % 8) % 8;
+	
+	block_database_trailer trailer;
+	trailer.block_count = index.size();
+	trailer.sequence_count = sequence_count;
+	trailer.index_offset = offset;
+	std::memcpy(trailer.magic, block_database_magic, sizeof(block_database_magic));
+	
+	if(!index.empty()) {
+		output.write(reinterpret_cast<const char *>(&index[0]), sizeof(block_database_entry) * index.size());
+	}
+	output.write(reinterpret_cast<const char *>(&trailer), sizeof(trailer));
+	
+	return true;
+}
+
+#endif
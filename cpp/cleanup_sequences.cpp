@@ -1,5 +1,9 @@
 #include "ordered_set.hh"
 #include "sequence.hh"
+#include "sequence_parser.hh"
+#include "binary_database.hh"
+#include "block_database.hh"
+#include "gzip_reader.hh"
 
 #include <iostream>
 #include <fstream>
@@ -8,8 +12,10 @@
 
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include <algorithm>
 #include <iterator>
 
 #include <limits>
@@ -27,18 +33,29 @@
 
 using namespace std;
 
+enum output_format {
+	text_format,
+	binary_format,
+	block_format
+};
+
 void usage(const char *filename) {
 	cout << "Cleanup Seqeunces" << endl << endl;
 	
-	cout << "Usage:  " << filename << " [-i/--itemset] [-n/--numeric n] infile [infile ...]" << endl;
+	cout << "Usage:  " << filename << " [-i/--itemset] [-n/--numeric n] [-l/--labeled] [-b/--binary | -z/--blocks] infile [infile ...]" << endl;
 	cout << "  --itemset      treate items as sets " << endl;
 	cout << "  --numeric      sequence items are treated as nonnegative integers" << endl;
+	cout << "  --labeled      each sequence is followed by a 0/1 label" << endl;
+	cout << "  --binary       convert to the binary database format (.sdb) instead of text (.fix)" << endl;
+	cout << "  --blocks       convert to the block compressed database format (.sbz) instead of text (.fix)" << endl;
 	cout << "  infile         input sequence database" << endl;
 }
 
-bool parse_args(int argc, char *argv[], bool &itemset, bool &numeric, vector<string> &infile) {
+bool parse_args(int argc, char *argv[], bool &itemset, bool &numeric, bool &labeled, output_format &format, vector<string> &infile) {
 	itemset = false;
 	numeric = false;
+	labeled = false;
+	format = text_format;
 	
 	infile.clear();
 	infile.reserve(argc);
@@ -57,6 +74,15 @@ bool parse_args(int argc, char *argv[], bool &itemset, bool &numeric, vector<str
 			else if(strcmp(argv[ii], "-n") == 0 || strcmp(argv[ii], "--numeric") == 0) {
 				numeric = true;
 			}
+			else if(strcmp(argv[ii], "-l") == 0 || strcmp(argv[ii], "--labeled") == 0) {
+				labeled = true;
+			}
+			else if(strcmp(argv[ii], "-b") == 0 || strcmp(argv[ii], "--binary") == 0) {
+				format = binary_format;
+			}
+			else if(strcmp(argv[ii], "-z") == 0 || strcmp(argv[ii], "--blocks") == 0) {
+				format = block_format;
+			}
 			else if(strcmp(argv[ii], "-h") == 0 || strcmp(argv[ii], "--help") == 0) {
 				usage(argv[0]);
 				
@@ -80,64 +106,72 @@ bool parse_args(int argc, char *argv[], bool &itemset, bool &numeric, vector<str
 	}
 }
 
-template <typename T>
-void load_database(const string &filename, vector<sequence<T> > &database) {
-	ifstream file(filename.c_str());
-	if(file) {
-		file >> database;
-		if(file.bad()) {
-			ostringstream oss;
-			oss <<  filename << ": " << strerror(errno);
-			
-			throw runtime_error(oss.str());
-		}
-		else if(file.fail() && !file.eof()) {
-			ostringstream oss;
-			oss <<  filename << ": error reading file";
-			
-			throw runtime_error(oss.str());
-		}
-	}
-	else {
+/* loads a text, binary, block compressed or gzip compressed database */
+template <typename Database>
+void load_database(const string &filename, Database &database) {
+	if(!parse_database_file(filename, database)) {
 		ostringstream oss;
-		oss <<  filename << ": " << strerror(errno);
+		oss <<  filename << ": error reading file";
 		
 		throw runtime_error(oss.str());
 	}
 }
 
 template <typename T>
-void process_files(const vector<string> &filenames) {
-	vector<sequence<T> > database;
+void write_text(ostream &output, const vector<sequence<T> > &database) {
+	output << database << endl;
+}
+
+template <typename T>
+void write_text(ostream &output, const vector<pair<bool,sequence<T> > > &database) {
+	typename vector<pair<bool,sequence<T> > >::const_iterator database_iter = database.begin();
+	for(; database_iter != database.end(); ++database_iter) {
+		output << database_iter->second << " " << database_iter->first << endl;
+	}
+}
+
+template <typename Database>
+void process_files(const vector<string> &filenames, output_format format) {
+	Database database;
 	
 	typename vector<string>::const_iterator filenames_iter = filenames.begin();
 	for(; filenames_iter != filenames.end(); ++filenames_iter) {
 		try {
 			database.clear();
 			load_database(*filenames_iter, database);
-
+			
 			std::string filename(*filenames_iter);
-			filename += ".fix";
-			std::ofstream file(filename.c_str());
+			filename += (format == binary_format) ? ".sdb" : (format == block_format) ? ".sbz" : ".fix";
+			std::ofstream file(filename.c_str(), (format == text_format) ? ios::out : ios::out | ios::binary);
 			if(file) {
-				file << database << std::endl;
+				bool written = true;
+				if(format == binary_format) {
+					write_binary_database(file, database);
+				}
+				else if(format == block_format) {
+					written = write_block_database(file, database);
+				}
+				else {
+					write_text(file, database);
+				}
+				
 				if(file.bad()) {
 					ostringstream oss;
 					oss <<  filename << ": " << strerror(errno);
-
+					
 					throw runtime_error(oss.str());
 				}
-				else if(file.fail()) {
+				else if(file.fail() || !written) {
 					ostringstream oss;
 					oss <<  filename << ": error writng file";
-
+					
 					throw runtime_error(oss.str());
 				}
 			}
 			else {
 				ostringstream oss;
 				oss <<  filename << ": " << strerror(errno);
-
+				
 				throw runtime_error(oss.str());
 			}
 		}
@@ -147,27 +181,39 @@ void process_files(const vector<string> &filenames) {
 	}
 }
 
+template <typename T>
+void process_files(const vector<string> &filenames, bool labeled, output_format format) {
+	if(labeled) {
+		process_files<vector<pair<bool,sequence<T> > > >(filenames, format);
+	}
+	else {
+		process_files<vector<sequence<T> > >(filenames, format);
+	}
+}
+
 int main(int argc, char *argv[]) {
 	bool itemset;
 	bool numeric;
+	bool labeled;
+	output_format format;
 	vector<string> input_files;
-
+	
 	try {
-		if(parse_args(argc, argv, itemset, numeric, input_files)) {
+		if(parse_args(argc, argv, itemset, numeric, labeled, format, input_files)) {
 			if(itemset) {
 				if(numeric) {
-					process_files<ordered_set<int> >(input_files);
+					process_files<ordered_set<int> >(input_files, labeled, format);
 				}
 				else {
-					process_files<ordered_set<string> >(input_files);
+					process_files<ordered_set<string> >(input_files, labeled, format);
 				}
 			}
 			else {
 				if(numeric) {
-					process_files<int>(input_files);
+					process_files<int>(input_files, labeled, format);
 				}
 				else {
-					process_files<string>(input_files);
+					process_files<string>(input_files, labeled, format);
 				}
 			}
 		}
@@ -175,6 +221,6 @@ int main(int argc, char *argv[]) {
 	catch(exception &e) {
 		cerr << e.what() << endl;
 	}
-
+	
 	return 0;
 }
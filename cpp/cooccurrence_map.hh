@@ -0,0 +1,279 @@
+#ifndef _COOCCURRENCE_MAP_HH_
+#define _COOCCURRENCE_MAP_HH_
+
+#include <iterator>
+#include <vector>
+#include <map>
+
+#include <algorithm>
+
+#include "ordered_set.hh"
+#include "sequence.hh"
+#include "flat_database.hh"
+
+/* frequent item pairs of a database (a co-occurrence map)
+ *
+ * records which pairs of frequent items a, b make a frequent 2-sequence <a,b>,
+ * and for itemsets which make a frequent element (a,b) with a < b. a pattern
+ * ending in a can only be extended by b when the pair is frequent, so miners
+ * can drop such candidates without projecting the database. a map that has
+ * not been built allows every extension. */
+template <typename Value>
+class cooccurrence_map {
+	public:
+		cooccurrence_map() : items(), sequence_pairs(), set_pairs() {
+			
+		}
+		
+		void clear() {
+			std::vector<Value>().swap(items);
+			std::vector<std::vector<unsigned int> >().swap(sequence_pairs);
+			std::vector<std::vector<unsigned int> >().swap(set_pairs);
+		}
+		
+		/* counts the pairs of the sorted items in the sequences [first, last),
+		 * the iterators pointing to sequences or sequence views */
+		template <typename Iter>
+		void build(Iter first, Iter last, const std::vector<Value> &frequent_items, unsigned int min_support) {
+			clear();
+			if(min_support == 0) {
+				return;
+			}
+			
+			items = frequent_items;
+			
+			if(items.size() <= dense_items) {
+				dense_pair_counts sequence_counts(items.size());
+				dense_pair_counts set_counts(items.size());
+				count_pairs(first, last, sequence_counts, set_counts);
+				
+				sequence_counts.frequent_pairs(min_support, sequence_pairs);
+				set_counts.frequent_pairs(min_support, set_pairs);
+			}
+			else {
+				sparse_pair_counts sequence_counts(items.size());
+				sparse_pair_counts set_counts(items.size());
+				count_pairs(first, last, sequence_counts, set_counts);
+				
+				sequence_counts.frequent_pairs(min_support, sequence_pairs);
+				set_counts.frequent_pairs(min_support, set_pairs);
+			}
+		}
+		
+		/* whether a pattern ending in item a can be followed by item b */
+		bool sequence_extension(const Value &a, const Value &b) const {
+			return frequent_pair(sequence_pairs, a, b);
+		}
+		
+		/* whether an element ending in item a can be grown by item b */
+		bool set_extension(const Value &a, const Value &b) const {
+			return frequent_pair(set_pairs, a, b);
+		}
+		
+	private:
+		static const unsigned int none = ~0u;
+		
+		std::vector<Value> items;
+		
+		/* for every item, the sorted indexes of the items it makes a frequent pair with */
+		std::vector<std::vector<unsigned int> > sequence_pairs;
+		std::vector<std::vector<unsigned int> > set_pairs;
+		
+		/* position of item in items, or items.size() when it is not listed */
+		std::size_t index(const Value &item) const {
+			typename std::vector<Value>::const_iterator items_iter = std::lower_bound(items.begin(), items.end(), item);
+			if(items_iter == items.end() || item < *items_iter) {
+				return items.size();
+			}
+			
+			return items_iter - items.begin();
+		}
+		
+		/* up to this many items the pairs are counted in a square matrix, above
+		 * it only the pairs that occur are counted, per item in a map */
+		static const std::size_t dense_items = 4096;
+		
+		class dense_pair_counts {
+			public:
+				explicit dense_pair_counts(std::size_t size) : size(size), counts() {
+					
+				}
+				
+				void add(unsigned int a, unsigned int b) {
+					if(counts.empty()) {
+						counts.resize(size * size, 0);
+					}
+					
+					counts[a * size + b]++;
+				}
+				
+				void frequent_pairs(unsigned int min_support, std::vector<std::vector<unsigned int> > &pairs) const {
+					pairs.resize(size);
+					for(std::size_t ii=0; ii < counts.size(); ii++) {
+						if(counts[ii] >= min_support) {
+							pairs[ii / size].push_back((unsigned int) (ii % size));
+						}
+					}
+				}
+				
+			private:
+				std::size_t size;
+				std::vector<unsigned int> counts;
+		};
+		
+		class sparse_pair_counts {
+			public:
+				explicit sparse_pair_counts(std::size_t size) : counts(size) {
+					
+				}
+				
+				void add(unsigned int a, unsigned int b) {
+					counts[a][b]++;
+				}
+				
+				void frequent_pairs(unsigned int min_support, std::vector<std::vector<unsigned int> > &pairs) const {
+					pairs.resize(counts.size());
+					for(std::size_t ii=0; ii < counts.size(); ii++) {
+						std::map<unsigned int,unsigned int>::const_iterator counts_iter = counts[ii].begin();
+						for(; counts_iter != counts[ii].end(); ++counts_iter) {
+							if(counts_iter->second >= min_support) {
+								pairs[ii].push_back(counts_iter->first);
+							}
+						}
+					}
+				}
+				
+			private:
+				std::vector<std::map<unsigned int,unsigned int> > counts;
+		};
+		
+		template <typename Iter, typename Counts>
+		void count_pairs(Iter first, Iter last, Counts &sequence_counts, Counts &set_counts) const {
+			std::vector<unsigned int> first_positions(items.size(), none);
+			std::vector<unsigned int> last_positions(items.size(), none);
+			std::vector<unsigned int> present;
+			std::vector<std::pair<unsigned int,unsigned int> > pairs;
+			
+			for(; first != last; ++first) {
+				add_sequence(**first, first_positions, last_positions, present, pairs);
+				
+				/* <a,b> occurs when some a comes before some b */
+				std::vector<unsigned int>::const_iterator present_iter = present.begin();
+				for(; present_iter != present.end(); ++present_iter) {
+					std::vector<unsigned int>::const_iterator other_iter = present.begin();
+					for(; other_iter != present.end(); ++other_iter) {
+						if(first_positions[*present_iter] < last_positions[*other_iter]) {
+							sequence_counts.add(*present_iter, *other_iter);
+						}
+					}
+				}
+				
+				for(present_iter = present.begin(); present_iter != present.end(); ++present_iter) {
+					first_positions[*present_iter] = none;
+					last_positions[*present_iter] = none;
+				}
+				present.clear();
+				
+				std::sort(pairs.begin(), pairs.end());
+				pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+				
+				std::vector<std::pair<unsigned int,unsigned int> >::const_iterator pairs_iter = pairs.begin();
+				for(; pairs_iter != pairs.end(); ++pairs_iter) {
+					set_counts.add(pairs_iter->first, pairs_iter->second);
+				}
+				pairs.clear();
+			}
+		}
+		
+		bool frequent_pair(const std::vector<std::vector<unsigned int> > &pairs, const Value &a, const Value &b) const {
+			if(pairs.empty()) {
+				return true;
+			}
+			
+			std::size_t a_index = index(a);
+			std::size_t b_index = index(b);
+			if(a_index == items.size() || b_index == items.size()) {
+				return true;
+			}
+			
+			return std::binary_search(pairs[a_index].begin(), pairs[a_index].end(), (unsigned int) b_index);
+		}
+		
+		/* records the first and last position of every listed item in seq */
+		void add_position(const Value &item, unsigned int position, std::vector<unsigned int> &first_positions, std::vector<unsigned int> &last_positions, std::vector<unsigned int> &present) const {
+			std::size_t item_id = index(item);
+			if(item_id == items.size()) {
+				return;
+			}
+			
+			if(first_positions[item_id] == none) {
+				first_positions[item_id] = position;
+				present.push_back(item_id);
+			}
+			last_positions[item_id] = position;
+		}
+		
+		template <typename Sequence>
+		void add_items(const Sequence &seq, std::vector<unsigned int> &first_positions, std::vector<unsigned int> &last_positions, std::vector<unsigned int> &present) const {
+			unsigned int position = 0;
+			
+			typename Sequence::const_iterator seq_iter = seq.begin();
+			for(; seq_iter != seq.end(); ++seq_iter, position++) {
+				add_position(*seq_iter, position, first_positions, last_positions, present);
+			}
+		}
+		
+		/* positions are those of the elements, and the pairs of listed items
+		 * sharing an element are collected in pairs */
+		template <typename Sequence>
+		void add_sets(const Sequence &seq, std::vector<unsigned int> &first_positions, std::vector<unsigned int> &last_positions, std::vector<unsigned int> &present, std::vector<std::pair<unsigned int,unsigned int> > &pairs) const {
+			std::vector<unsigned int> element;
+			unsigned int position = 0;
+			
+			typename Sequence::const_iterator seq_iter = seq.begin();
+			for(; seq_iter != seq.end(); ++seq_iter, position++) {
+				element.clear();
+				
+				typename std::iterator_traits<typename Sequence::const_iterator>::value_type::const_iterator set_iter = seq_iter->begin();
+				for(; set_iter != seq_iter->end(); ++set_iter) {
+					add_position(*set_iter, position, first_positions, last_positions, present);
+					
+					std::size_t item_id = index(*set_iter);
+					if(item_id < items.size()) {
+						element.push_back((unsigned int) item_id);
+					}
+				}
+				
+				/* elements are sorted, so every pair is (smaller, larger) */
+				for(std::size_t ii=0; ii < element.size(); ii++) {
+					for(std::size_t jj=ii+1; jj < element.size(); jj++) {
+						pairs.push_back(std::make_pair(element[ii], element[jj]));
+					}
+				}
+			}
+		}
+		
+		void add_sequence(const sequence<Value> &seq, std::vector<unsigned int> &first_positions, std::vector<unsigned int> &last_positions, std::vector<unsigned int> &present, std::vector<std::pair<unsigned int,unsigned int> > &) const {
+			add_items(seq, first_positions, last_positions, present);
+		}
+		
+		void add_sequence(const sequence_view<Value> &seq, std::vector<unsigned int> &first_positions, std::vector<unsigned int> &last_positions, std::vector<unsigned int> &present, std::vector<std::pair<unsigned int,unsigned int> > &) const {
+			add_items(seq, first_positions, last_positions, present);
+		}
+		
+		void add_sequence(const sequence<ordered_set<Value> > &seq, std::vector<unsigned int> &first_positions, std::vector<unsigned int> &last_positions, std::vector<unsigned int> &present, std::vector<std::pair<unsigned int,unsigned int> > &pairs) const {
+			add_sets(seq, first_positions, last_positions, present, pairs);
+		}
+		
+		void add_sequence(const sequence_view<ordered_set<Value> > &seq, std::vector<unsigned int> &first_positions, std::vector<unsigned int> &last_positions, std::vector<unsigned int> &present, std::vector<std::pair<unsigned int,unsigned int> > &pairs) const {
+			add_sets(seq, first_positions, last_positions, present, pairs);
+		}
+};
+
+template <typename Value>
+const unsigned int cooccurrence_map<Value>::none;
+
+template <typename Value>
+const std::size_t cooccurrence_map<Value>::dense_items;
+
+#endif
@@ -20,7 +20,7 @@
 #include <cerrno>
 #include <cstring>
 
-#include "gzstream.h"
+#include "gzip_reader.hh"
 
 #include "counter.hh"
 
@@ -226,8 +226,13 @@ inline bool ends_with(const std::string &str, const std::string &suffix) {
 template <typename T>
 void load_database(const string &filename, vector<sequence<T> > &database) {
 	if(ends_with(filename, ".gz")) {
-		igzstream file(filename.c_str());
-		load_database(file, filename, database);
+		gzip_reader file(filename);
+		if(!parse_database(file, database)) {
+			ostringstream oss;
+			oss <<  filename << ": error reading file";
+			
+			throw runtime_error(oss.str());
+		}
 	}
 	else {
 		ifstream file(filename.c_str());
@@ -238,8 +243,13 @@ void load_database(const string &filename, vector<sequence<T> > &database) {
 template <typename T>
 void load_labeled_database(const string &filename, std::vector<std::pair<bool,sequence<T> > > &database) {
 	if(ends_with(filename, ".gz")) {
-		igzstream file(filename.c_str());
-		load_labeled_database(file, filename, database);
+		gzip_reader file(filename);
+		if(!parse_database(file, database)) {
+			ostringstream oss;
+			oss <<  filename << ": error reading file";
+			
+			throw runtime_error(oss.str());
+		}
 	}
 	else {
 		ifstream file(filename.c_str());
@@ -1,5 +1,8 @@
 #include "ordered_set.hh"
 #include "sequence.hh"
+#include "sequence_parser.hh"
+#include "gzip_reader.hh"
+#include "pattern_file.hh"
 
 #include <iostream>
 #include <fstream>
@@ -19,8 +22,6 @@
 #include <cerrno>
 #include <cstring>
 
-#include "gzstream.h"
-
 #include "counter.hh"
 
 #ifndef NDEBUG
@@ -32,15 +33,18 @@ using namespace std;
 void usage(const char *filename) {
 	cout << "Sequence Evaluation"	<< endl << endl;
 	
-	cout << "Usage:  " << filename << " [-i/--itemset] [-n/--numeric n] seq_file db_file" << endl;
+	cout << "Usage:  " << filename << " [-i/--itemset] [-n/--numeric n] [-x/--index] seq_file db_file" << endl;
 	cout << "  --itemset      treate items as sets " << endl;
 	cout << "  --numeric      sequence items are treated as nonnegative integers" << endl;
-	cout << "  infile         input sequence database" << endl;
+	cout << "  --index        index item positions in every database sequence, faster for many or long sequences" << endl;
+	cout << "  seq_file       sequences to evaluate, or a binary pattern file whose supports are added to the output" << endl;
+	cout << "  db_file        labeled sequence database" << endl;
 }
 
-bool parse_args(int argc, char *argv[], bool &itemset, bool &numeric, string &seq_file, string &db_file) {
+bool parse_args(int argc, char *argv[], bool &itemset, bool &numeric, bool &index, string &seq_file, string &db_file) {
 	itemset = false;
 	numeric = false;
+	index = false;
 	
 	seq_file.clear();
 	db_file.clear();
@@ -59,6 +63,9 @@ bool parse_args(int argc, char *argv[], bool &itemset, bool &numeric, string &se
 			else if(strcmp(argv[ii], "-n") == 0 || strcmp(argv[ii], "--numeric") == 0) {
 				numeric = true;
 			}
+			else if(strcmp(argv[ii], "-x") == 0 || strcmp(argv[ii], "--index") == 0) {
+				index = true;
+			}
 			else if(strcmp(argv[ii], "-h") == 0 || strcmp(argv[ii], "--help") == 0) {
 				usage(argv[0]);
 				
@@ -73,7 +80,7 @@ bool parse_args(int argc, char *argv[], bool &itemset, bool &numeric, string &se
 			else {
 				std::cerr << "Unrecognized input option " << argv[ii] << std::endl << std::endl;
 				usage(argv[0]);
-
+				
 				return false;
 			} 
 			
@@ -92,98 +99,68 @@ bool parse_args(int argc, char *argv[], bool &itemset, bool &numeric, string &se
 }
 
 template <typename T>
-void load_database(istream &file, const string &filename, vector<sequence<T> > &database) {
-	if(file) {
-		file >> database;
-		if(file.bad()) {
-			ostringstream oss;
-			oss <<  filename << ": " << strerror(errno);
-			
-			throw runtime_error(oss.str());
-		}
-		else if(file.fail() && !file.eof()) {
-			ostringstream oss;
-			oss <<  filename << ": error reading file";
-			
-			throw runtime_error(oss.str());
-		}
-	}
-	else {
+void load_database(const string &filename, vector<sequence<T> > &database) {
+	if(!parse_database_file(filename, database)) {
 		ostringstream oss;
-		oss <<  filename << ": " << strerror(errno);
+		oss <<  filename << ": error reading file";
 		
 		throw runtime_error(oss.str());
 	}
 }
 
 template <typename T>
-void load_labeled_database(istream &file, const std::string &filename, std::vector<std::pair<bool,sequence<T> > > &database) {
-	if(file) {
-		file >> database;
-		if(file.bad()) {
-			std::ostringstream oss;
-			oss <<  filename << ": " << strerror(errno);
-
-			throw std::runtime_error(oss.str());
-		}   
-		else if(file.fail() && !file.eof()) {
-			std::ostringstream oss;
-			oss <<  filename << ": error reading file";
-
-			throw std::runtime_error(oss.str());
-		}   
-	}   
-	else {
-		std::ostringstream oss;
-		oss <<  filename << ": " << strerror(errno);
-
-		throw std::runtime_error(oss.str());
-
-	}   
-}
-
-inline bool ends_with(const std::string &str, const std::string &suffix) {
-	if(suffix.size() > str.size()) {
-		return false;
-	}
-
-	return std::equal(suffix.rbegin(), suffix.rend(), str.rbegin());
-}
-
-template <typename T>
-void load_database(const string &filename, vector<sequence<T> > &database) {
-	if(ends_with(filename, ".gz")) {
-		igzstream file(filename.c_str());
-		load_database(file, filename, database);
-	}
-	else {
-		ifstream file(filename.c_str());
-		load_database(file, filename, database);
+void load_labeled_database(const string &filename, std::vector<std::pair<bool,sequence<T> > > &database) {
+	if(!parse_database_file(filename, database)) {
+		ostringstream oss;
+		oss <<  filename << ": error reading file";
+		
+		throw runtime_error(oss.str());
 	}
 }
 
+/* loads the sequences to evaluate, returns true when the file also records their supports */
 template <typename T>
-void load_labeled_database(const string &filename, std::vector<std::pair<bool,sequence<T> > > &database) {
-	if(ends_with(filename, ".gz")) {
-		igzstream file(filename.c_str());
-		load_labeled_database(file, filename, database);
+bool load_patterns(const string &filename, vector<pair<unsigned int,sequence<T> > > &patterns) {
+	if(is_pattern_file(filename)) {
+		read_patterns(filename, patterns);
+		return true;
 	}
-	else {
-		ifstream file(filename.c_str());
-		load_labeled_database(file, filename, database);
+	
+	vector<sequence<T> > sequences;
+	load_database(filename, sequences);
+	
+	patterns.clear();
+	patterns.reserve(sequences.size());
+	
+	typename vector<sequence<T> >::iterator sequences_iter = sequences.begin();
+	for(; sequences_iter != sequences.end(); ++sequences_iter) {
+		patterns.push_back(pair<unsigned int,sequence<T> >(0, sequence<T>()));
+		patterns.back().second.swap(*sequences_iter);
 	}
+	
+	return false;
 }
 
 template <typename T>
-void process_file(const string &seq_filename, const string &db_filename) {
-	vector<sequence<T> > sequences;
+void process_file(const string &seq_filename, const string &db_filename, bool index) {
+	vector<pair<unsigned int,sequence<T> > > patterns;
 	vector<pair<bool,sequence<T> > > database;
-
+	
 	load_labeled_database(db_filename, database);
-	load_database(seq_filename, sequences);
-
-	typename vector<sequence<T> >::iterator sequences_iter = sequences.begin();
-	for(; sequences_iter != sequences.end(); ++sequences_iter) {
+	bool supports = load_patterns(seq_filename, patterns);
+	
+	vector<position_index<T> > indexes;
+	if(index) {
+		indexes.resize(database.size());
+		for(size_t ii=0; ii < database.size(); ii++) {
+			position_index<T>(database[ii].second).swap(indexes[ii]);
+		}
+	}
+	
+	typename vector<pair<unsigned int,sequence<T> > >::iterator patterns_iter = patterns.begin();
+	for(; patterns_iter != patterns.end(); ++patterns_iter) {
+		const sequence<T> &seq = patterns_iter->second;
+		
 		unsigned int TP = 0;
 		unsigned int TN = 0;
 		unsigned int FP = 0;
@@ -191,7 +168,7 @@ void process_file(const string &seq_filename, const string &db_filename) {
 		
 		typename vector<pair<bool,sequence<T> > >::iterator database_iter = database.begin();
 		for(; database_iter != database.end(); ++database_iter) {
-			if(sequences_iter->subsequence(database_iter->second)) {
+			if(index ? seq.subsequence(indexes[database_iter - database.begin()]) : seq.subsequence(database_iter->second)) {
 				if(database_iter->first) {
 					TP++;
 				}
@@ -208,33 +185,38 @@ void process_file(const string &seq_filename, const string &db_filename) {
 				}
 			}
 		}
-
-		std::cout << *sequences_iter << " " << TP << " " << FP << " " << TN << " " << FN << std::endl;
+		
+		std::cout << seq << " " << TP << " " << FP << " " << TN << " " << FN;
+		if(supports) {
+			std::cout << " " << patterns_iter->first;
+		}
+		std::cout << std::endl;
 	}
 }
 
 int main(int argc, char *argv[]) {
 	bool itemset;
 	bool numeric;
+	bool index;
 	string seq_filename;
 	string db_filename;
-
+	
 	try {
-		if(parse_args(argc, argv, itemset, numeric, seq_filename, db_filename)) {
+		if(parse_args(argc, argv, itemset, numeric, index, seq_filename, db_filename)) {
 			if(itemset) {
 				if(numeric) {
-					process_file<ordered_set<int> >(seq_filename, db_filename);
+					process_file<ordered_set<int> >(seq_filename, db_filename, index);
 				}
 				else {
-					process_file<ordered_set<string> >(seq_filename, db_filename);
+					process_file<ordered_set<string> >(seq_filename, db_filename, index);
 				}
 			}
 			else {
 				if(numeric) {
-					process_file<int>(seq_filename, db_filename);
+					process_file<int>(seq_filename, db_filename, index);
 				}
 				else {
-					process_file<string>(seq_filename, db_filename);
+					process_file<string>(seq_filename, db_filename, index);
 				}
 			}
 		}
@@ -242,6 +224,6 @@ int main(int argc, char *argv[]) {
 	catch(exception &e) {
 		cerr << e.what() << endl;
 	}
-
+	
 	return 0;
 }
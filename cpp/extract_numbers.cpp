@@ -17,76 +17,37 @@
 #include <cstring>
 
 #include "sequence.hh"
-
-void read_database(const std::string &filename, std::vector<sequence<int> > &database) {
-	std::ifstream file(filename.c_str());
-	if(file) {
-		file >> database;
-		if(file.bad()) {
-			std::ostringstream oss;
-			oss <<  filename << ": " << strerror(errno);
-			
-			throw std::runtime_error(oss.str());
-		}
-		else if(file.fail() && !file.eof()) {
-			std::ostringstream oss;
-			oss <<  filename << ": error reading file";
-			
-			throw std::runtime_error(oss.str());
-		}
-	}
-	else {
-		std::ostringstream oss;
-		oss <<  filename << ": " << strerror(errno);
-		
-		throw std::runtime_error(oss.str());
-
-	}
-}
+#include "sequence_parser.hh"
+#include "mapped_file.hh"
+#include "pattern_file.hh"
 
 void read_labeled_database(const std::string &filename, std::vector<std::pair<bool,sequence<int> > > &database) {
-	std::ifstream file(filename.c_str());
-	if(file) {
-		file >> database;
-		if(file.bad()) {
-			std::ostringstream oss;
-			oss <<  filename << ": " << strerror(errno);
-			
-			throw std::runtime_error(oss.str());
-		}
-		else if(file.fail() && !file.eof()) {
-			std::ostringstream oss;
-			oss <<  filename << ": error reading file";
-			
-			throw std::runtime_error(oss.str());
-		}
-	}
-	else {
+	mapped_file file(filename);
+	if(!parse_database(file.begin(), file.end(), database)) {
 		std::ostringstream oss;
-		oss <<  filename << ": " << strerror(errno);
+		oss <<  filename << ": error reading file";
 		
 		throw std::runtime_error(oss.str());
-
 	}
 }
 
 int main(int argc, char *argv[]) {
-	std::vector<sequence<int> > results;
-	read_database("/tmp/work/synthetic.patterns.dat", results);
-
+	std::vector<std::pair<unsigned int,sequence<int> > > results;
+	read_patterns("/tmp/work/synthetic.patterns.dat", results);
+	
 	std::vector<std::pair<bool,sequence<int> > > database;
 	read_labeled_database("/tmp/work/synthetic.class.dat", database);
-
-	std::vector<sequence<int> >::iterator results_iter = results.begin();
+	
+	std::vector<std::pair<unsigned int,sequence<int> > >::iterator results_iter = results.begin();
 	for(; results_iter != results.end(); ++results_iter) {
 		unsigned int TP = 0;
 		unsigned int FP = 0;
 		unsigned int TN = 0;
 		unsigned int FN = 0;
-
+		
 		std::vector<std::pair<bool,sequence<int> > >::iterator database_iter = database.begin();
 		for(; database_iter != database.end(); ++database_iter) {
-			if(results_iter->subsequence(database_iter->second)) {
+			if(results_iter->second.subsequence(database_iter->second)) {
 				if(database_iter->first) {
 					TP++;
 				}
@@ -103,10 +64,10 @@ int main(int argc, char *argv[]) {
 				}
 			}
 		}
-
-		std::cout << *results_iter << " " << TP << " " << FP << " " << TN << " " << FN << std::endl;
+		
+		std::cout << results_iter->second << " " << TP << " " << FP << " " << TN << " " << FN << std::endl;
 	}
-
+	
 	
 	return 0;
 }
@@ -0,0 +1,422 @@
+#ifndef _FLAT_DATABASE_HH_
+#define _FLAT_DATABASE_HH_
+
+#include <iostream>
+#include <ostream>
+
+#include <iterator>
+#include <vector>
+
+#include <algorithm>
+
+#include <cstddef>
+
+#include "infix_iterator.hh"
+#include "ordered_set.hh"
+#include "sequence.hh"
+
+/* read-only view of an itemset stored in a flat_database */
+template <typename T>
+class set_view {
+	public:
+		typedef std::size_t size_type;
+		typedef const T * const_iterator;
+		
+		set_view() : first(NULL), last(NULL) {
+			
+		}
+		
+		set_view(const T *first, const T *last) : first(first), last(last) {
+			
+		}
+		
+		const_iterator begin() const {
+			return first;
+		}
+		
+		const_iterator end() const {
+			return last;
+		}
+		
+		size_type size() const {
+			return last - first;
+		}
+		
+		bool empty() const {
+			return first == last;
+		}
+		
+		const T & operator[](size_type index) const {
+			return first[index];
+		}
+		
+		bool contains(const T &element) const {
+			return std::binary_search(first, last, element);
+		}
+		
+		friend std::ostream & operator<<(std::ostream &output, const set_view &set) {
+			output << "(";
+			std::copy(set.begin(), set.end(), infix_ostream_iterator<T>(output, ","));
+			output << ")";
+			
+			return output;
+		}
+		
+	protected:
+		const T *first;
+		const T *last;
+};
+
+/* read-only view of a sequence stored in a flat_database */
+template <typename T>
+class sequence_view {
+	public:
+		typedef std::size_t size_type;
+		typedef const T * const_iterator;
+		
+		sequence_view() : first(NULL), last(NULL) {
+			
+		}
+		
+		sequence_view(const T *first, const T *last) : first(first), last(last) {
+			
+		}
+		
+		const_iterator begin() const {
+			return first;
+		}
+		
+		const_iterator end() const {
+			return last;
+		}
+		
+		size_type length() const {
+			return last - first;
+		}
+		
+		bool empty() const {
+			return first == last;
+		}
+		
+		const T & operator[](size_type index) const {
+			return first[index];
+		}
+		
+		friend std::ostream & operator<<(std::ostream &output, const sequence_view &seq) {
+			output << "<";
+			std::copy(seq.begin(), seq.end(), infix_ostream_iterator<T>(output, ","));
+			output << ">";
+			
+			return output;
+		}
+		
+	protected:
+		const T *first;
+		const T *last;
+};
+
+template <typename T>
+class sequence_view<ordered_set<T> > {
+	public:
+		typedef std::size_t size_type;
+		
+		/* iterates the itemsets of the sequence, dereferencing to a set_view */
+		class const_iterator {
+			public:
+				typedef std::forward_iterator_tag iterator_category;
+				typedef set_view<T> value_type;
+				typedef std::ptrdiff_t difference_type;
+				typedef const set_view<T> * pointer;
+				typedef const set_view<T> & reference;
+				
+				const_iterator() : items(NULL), offset(NULL), current() {
+					
+				}
+				
+				const_iterator(const T *items, const size_type *offset) : items(items), offset(offset), current() {
+					
+				}
+				
+				set_view<T> operator*() const {
+					return set_view<T>(items + offset[0], items + offset[1]);
+				}
+				
+				const set_view<T> * operator->() const {
+					current = set_view<T>(items + offset[0], items + offset[1]);
+					return &current;
+				}
+				
+				const_iterator & operator++() {
+					++offset;
+					return *this;
+				}
+				
+				const_iterator operator++(int) {
+					const_iterator tmp(*this);
+					++offset;
+					return tmp;
+				}
+				
+				friend bool operator==(const const_iterator &lhs, const const_iterator &rhs) {
+					return lhs.offset == rhs.offset;
+				}
+				
+				friend bool operator!=(const const_iterator &lhs, const const_iterator &rhs) {
+					return lhs.offset != rhs.offset;
+				}
+				
+			protected:
+				const T *items;
+				const size_type *offset;
+				mutable set_view<T> current;
+		};
+		
+		sequence_view() : items(NULL), offsets(NULL), count(0) {
+			
+		}
+		
+		/* offsets holds count+1 itemset boundaries into items */
+		sequence_view(const T *items, const size_type *offsets, size_type count) : items(items), offsets(offsets), count(count) {
+			
+		}
+		
+		const_iterator begin() const {
+			return const_iterator(items, offsets);
+		}
+		
+		const_iterator end() const {
+			return const_iterator(items, offsets + count);
+		}
+		
+		size_type length() const {
+			return count;
+		}
+		
+		bool empty() const {
+			return count == 0;
+		}
+		
+		set_view<T> operator[](size_type index) const {
+			return set_view<T>(items + offsets[index], items + offsets[index+1]);
+		}
+		
+		friend std::ostream & operator<<(std::ostream &output, const sequence_view &seq) {
+			output << "<";
+			for(size_type ii=0; ii < seq.length(); ii++) {
+				if(ii > 0) {
+					output << ",";
+				}
+				output << seq[ii];
+			}
+			output << ">";
+			
+			return output;
+		}
+		
+	protected:
+		const T *items;
+		const size_type *offsets;
+		size_type count;
+};
+
+/* iterates a flat database by index, dereferencing to sequence views */
+template <typename Database>
+class flat_database_iterator {
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef typename Database::value_type value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const value_type * pointer;
+		typedef const value_type & reference;
+		
+		flat_database_iterator() : database(NULL), index(0) {
+			
+		}
+		
+		flat_database_iterator(const Database *database, typename Database::size_type index) : database(database), index(index) {
+			
+		}
+		
+		value_type operator*() const {
+			return (*database)[index];
+		}
+		
+		flat_database_iterator & operator++() {
+			++index;
+			return *this;
+		}
+		
+		flat_database_iterator operator++(int) {
+			flat_database_iterator tmp(*this);
+			++index;
+			return tmp;
+		}
+		
+		friend bool operator==(const flat_database_iterator &lhs, const flat_database_iterator &rhs) {
+			return lhs.index == rhs.index;
+		}
+		
+		friend bool operator!=(const flat_database_iterator &lhs, const flat_database_iterator &rhs) {
+			return lhs.index != rhs.index;
+		}
+		
+	protected:
+		const Database *database;
+		typename Database::size_type index;
+};
+
+/* read-only sequence database stored as one item array plus sequence offsets */
+template <typename T>
+class flat_database {
+	public:
+		typedef std::size_t size_type;
+		typedef sequence_view<T> value_type;
+		typedef flat_database_iterator<flat_database> const_iterator;
+		
+		flat_database() : items(), sequence_offsets(1, 0) {
+			
+		}
+		
+		template <typename Iter>
+		flat_database(Iter first, Iter last) : items(), sequence_offsets(1, 0) {
+			for(; first != last; ++first) {
+				push_back(*first);
+			}
+		}
+		
+		const_iterator begin() const {
+			return const_iterator(this, 0);
+		}
+		
+		const_iterator end() const {
+			return const_iterator(this, size());
+		}
+		
+		size_type size() const {
+			return sequence_offsets.size() - 1;
+		}
+		
+		bool empty() const {
+			return size() == 0;
+		}
+		
+		size_type item_count() const {
+			return items.size();
+		}
+		
+		sequence_view<T> operator[](size_type index) const {
+			const T *data = items.empty() ? NULL : &items[0];
+			return sequence_view<T>(data + sequence_offsets[index], data + sequence_offsets[index+1]);
+		}
+		
+		template <typename Sequence>
+		void push_back(const Sequence &seq) {
+			items.insert(items.end(), seq.begin(), seq.end());
+			sequence_offsets.push_back(items.size());
+		}
+		
+		void reserve(size_type sequences, size_type total_items) {
+			sequence_offsets.reserve(sequences + 1);
+			items.reserve(total_items);
+		}
+		
+		void clear() {
+			items.clear();
+			sequence_offsets.assign(1, 0);
+		}
+		
+		void swap(flat_database &other) {
+			items.swap(other.items);
+			sequence_offsets.swap(other.sequence_offsets);
+		}
+		
+	protected:
+		std::vector<T> items;
+		std::vector<size_type> sequence_offsets;
+};
+
+/* read-only itemset sequence database stored as one item array plus itemset and sequence offsets */
+template <typename T>
+class flat_database<ordered_set<T> > {
+	public:
+		typedef std::size_t size_type;
+		typedef sequence_view<ordered_set<T> > value_type;
+		typedef flat_database_iterator<flat_database> const_iterator;
+		
+		flat_database() : items(), itemset_offsets(1, 0), sequence_offsets(1, 0) {
+			
+		}
+		
+		template <typename Iter>
+		flat_database(Iter first, Iter last) : items(), itemset_offsets(1, 0), sequence_offsets(1, 0) {
+			for(; first != last; ++first) {
+				push_back(*first);
+			}
+		}
+		
+		const_iterator begin() const {
+			return const_iterator(this, 0);
+		}
+		
+		const_iterator end() const {
+			return const_iterator(this, size());
+		}
+		
+		size_type size() const {
+			return sequence_offsets.size() - 1;
+		}
+		
+		bool empty() const {
+			return size() == 0;
+		}
+		
+		size_type item_count() const {
+			return items.size();
+		}
+		
+		sequence_view<ordered_set<T> > operator[](size_type index) const {
+			const T *data = items.empty() ? NULL : &items[0];
+			return sequence_view<ordered_set<T> >(data, &itemset_offsets[sequence_offsets[index]], sequence_offsets[index+1] - sequence_offsets[index]);
+		}
+		
+		template <typename Sequence>
+		void push_back(const Sequence &seq) {
+			typename Sequence::const_iterator seq_iter = seq.begin();
+			for(; seq_iter != seq.end(); ++seq_iter) {
+				items.insert(items.end(), seq_iter->begin(), seq_iter->end());
+				itemset_offsets.push_back(items.size());
+			}
+			
+			sequence_offsets.push_back(itemset_offsets.size() - 1);
+		}
+		
+		void reserve(size_type sequences, size_type itemsets, size_type total_items) {
+			sequence_offsets.reserve(sequences + 1);
+			itemset_offsets.reserve(itemsets + 1);
+			items.reserve(total_items);
+		}
+		
+		void clear() {
+			items.clear();
+			itemset_offsets.assign(1, 0);
+			sequence_offsets.assign(1, 0);
+		}
+		
+		void swap(flat_database &other) {
+			items.swap(other.items);
+			itemset_offsets.swap(other.itemset_offsets);
+			sequence_offsets.swap(other.sequence_offsets);
+		}
+		
+	protected:
+		std::vector<T> items;
+		std::vector<size_type> itemset_offsets;
+		std::vector<size_type> sequence_offsets;
+};
+
+template <typename T>
+void swap(flat_database<T> &x, flat_database<T> &y) {
+	x.swap(y);
+}
+
+#endif
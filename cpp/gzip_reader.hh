@@ -0,0 +1,291 @@
+#ifndef _GZIP_READER_HH_
+#define _GZIP_READER_HH_
+
+#include <sstream>
+
+#include <string>
+#include <vector>
+
+#include <stdexcept>
+
+#include <cerrno>
+#include <cstring>
+
+#include <pthread.h>
+#include <zlib.h>
+
+#include "sequence_parser.hh"
+#include "mapped_file.hh"
+#include "block_database.hh"
+
+/* sequential reader for gzip compressed files
+ *
+ * a decompression thread inflates the file into a bounded ring of large
+ * blocks while the caller consumes the blocks already filled, so inflating
+ * the next block overlaps with parsing the current one. */
+class gzip_reader {
+	public:
+		gzip_reader(const std::string &file_name, std::size_t block_size=1 << 22, unsigned int block_count=4) : file_name(file_name), file(NULL), block_size(block_size), blocks(block_count), sizes(block_count, 0), head(0), filled(0), current(false), finished(false), stopped(false), error(0), error_message() {
+			errno = 0;
+			file = gzopen(file_name.c_str(), "rb");
+			if(file == NULL) {
+				if(errno == 0) {
+					errno = ENOMEM;
+				}
+				
+				throw_error(strerror(errno));
+			}
+			
+			gzbuffer(file, 1 << 20);
+			
+			pthread_mutex_init(&mutex, NULL);
+			pthread_cond_init(&not_empty, NULL);
+			pthread_cond_init(&not_full, NULL);
+			
+			if(pthread_create(&thread, NULL, inflate_blocks, this) != 0) {
+				pthread_cond_destroy(&not_full);
+				pthread_cond_destroy(&not_empty);
+				pthread_mutex_destroy(&mutex);
+				gzclose(file);
+				
+				throw_error("cannot start decompression thread");
+			}
+		}
+		
+		~gzip_reader() {
+			pthread_mutex_lock(&mutex);
+			stopped = true;
+			pthread_cond_signal(&not_full);
+			pthread_mutex_unlock(&mutex);
+			
+			pthread_join(thread, NULL);
+			
+			pthread_cond_destroy(&not_full);
+			pthread_cond_destroy(&not_empty);
+			pthread_mutex_destroy(&mutex);
+			gzclose(file);
+		}
+		
+		/* hands out the next block of decompressed data, which stays valid until
+		 * the following call. returns false at the end of the file and throws when
+		 * the file cannot be decompressed */
+		bool next(const char *&begin, const char *&end) {
+			pthread_mutex_lock(&mutex);
+			
+			if(current) {
+				head = (head + 1) % blocks.size();
+				filled--;
+				current = false;
+				pthread_cond_signal(&not_full);
+			}
+			
+			while(filled == 0 && !finished) {
+				pthread_cond_wait(&not_empty, &mutex);
+			}
+			
+			if(filled == 0) {
+				int status = error;
+				std::string message = error_message;
+				pthread_mutex_unlock(&mutex);
+				
+				if(status != Z_OK) {
+					throw_error(message);
+				}
+				
+				return false;
+			}
+			
+			begin = &blocks[head][0];
+			end = begin + sizes[head];
+			current = true;
+			
+			pthread_mutex_unlock(&mutex);
+			
+			return true;
+		}
+		
+	private:
+		std::string file_name;
+		gzFile file;
+		
+		/* ring of blocks, filled blocks start at head. blocks are allocated by
+		 * the decompression thread when first used */
+		std::size_t block_size;
+		std::vector<std::vector<char> > blocks;
+		std::vector<std::size_t> sizes;
+		std::size_t head;
+		std::size_t filled;
+		bool current;
+		
+		bool finished;
+		bool stopped;
+		int error;
+		std::string error_message;
+		
+		pthread_t thread;
+		pthread_mutex_t mutex;
+		pthread_cond_t not_empty;
+		pthread_cond_t not_full;
+		
+		/* not copyable, the thread and the file are owned */
+		gzip_reader(const gzip_reader &);
+		gzip_reader & operator=(const gzip_reader &);
+		
+		static void * inflate_blocks(void *reader) {
+			static_cast<gzip_reader *>(reader)->inflate_blocks();
+			return NULL;
+		}
+		
+		void inflate_blocks() {
+			for(;;) {
+				pthread_mutex_lock(&mutex);
+				while(filled == blocks.size() && !stopped) {
+					pthread_cond_wait(&not_full, &mutex);
+				}
+				
+				std::size_t tail = (head + filled) % blocks.size();
+				bool stop = stopped;
+				pthread_mutex_unlock(&mutex);
+				
+				if(stop) {
+					break;
+				}
+				
+				/* only this thread touches the tail block until it is published */
+				std::vector<char> &block = blocks[tail];
+				block.resize(block_size);
+				
+				std::size_t size = 0;
+				int count = 0;
+				while(size < block.size() && (count = gzread(file, &block[size], block.size() - size)) > 0) {
+					size += count;
+				}
+				
+				pthread_mutex_lock(&mutex);
+				if(size > 0) {
+					sizes[tail] = size;
+					filled++;
+				}
+				
+				if(count <= 0) {
+					/* a truncated file ends like a complete one but leaves Z_BUF_ERROR */
+					int status;
+					const char *message = gzerror(file, &status);
+					if(status != Z_OK) {
+						error = status;
+						error_message = (status == Z_ERRNO) ? strerror(errno) : message;
+						
+						/* zlib prefixes its messages with the file name */
+						if(error_message.compare(0, file_name.size() + 2, file_name + ": ") == 0) {
+							error_message.erase(0, file_name.size() + 2);
+						}
+					}
+					
+					finished = true;
+				}
+				
+				pthread_cond_signal(&not_empty);
+				pthread_mutex_unlock(&mutex);
+				
+				if(count <= 0) {
+					break;
+				}
+			}
+		}
+		
+		void throw_error(const std::string &message) const {
+			std::ostringstream oss;
+			oss <<  file_name << ": " << message;
+			
+			throw std::runtime_error(oss.str());
+		}
+};
+
+/* start of the last line in [begin, end) that begins a sequence, end if there is none */
+inline const char * last_sequence(const char *begin, const char *end) {
+	for(const char *position = end; position - begin >= 2; --position) {
+		if(position[-1] == '<' && position[-2] == '\n') {
+			return position - 1;
+		}
+	}
+	
+	return end;
+}
+
+/* parses a compressed database block by block. complete sequences are parsed
+ * straight out of each block and only the sequence spanning two blocks is
+ * copied. binary databases are gathered and decoded as a whole */
+template <typename Container>
+bool parse_database(gzip_reader &reader, Container &container) {
+	Container tmp_container;
+	std::vector<char> carry;
+	
+	const char *begin, *end;
+	bool first = true;
+	while(reader.next(begin, end)) {
+		if(first && is_binary_database(begin, end)) {
+			carry.assign(begin, end);
+			while(reader.next(begin, end)) {
+				carry.insert(carry.end(), begin, end);
+			}
+			
+			return parse_database(carry, container);
+		}
+		first = false;
+		
+		/* a block starting with '<' right after a line break starts a sequence */
+		const char *first_cut = (!carry.empty() && carry[carry.size()-1] == '\n' && *begin == '<') ? begin : next_sequence(begin, end);
+		if(first_cut == end) {
+			carry.insert(carry.end(), begin, end);
+			continue;
+		}
+		
+		carry.insert(carry.end(), begin, first_cut);
+		if(!carry.empty() && !parse_chunks(&carry[0], &carry[0] + carry.size(), tmp_container)) {
+			return false;
+		}
+		
+		const char *last_cut = last_sequence(first_cut, end);
+		if(last_cut == end) {
+			last_cut = first_cut;
+		}
+		
+		if(!parse_chunks(first_cut, last_cut, tmp_container)) {
+			return false;
+		}
+		
+		carry.assign(last_cut, end);
+	}
+	
+	if(!carry.empty() && !parse_chunks(&carry[0], &carry[0] + carry.size(), tmp_container)) {
+		return false;
+	}
+	
+	container.swap(tmp_container);
+	return true;
+}
+
+inline bool is_gzip_file(const std::string &file_name) {
+	static const std::string suffix(".gz");
+	
+	return file_name.size() >= suffix.size() && file_name.compare(file_name.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/* parses a database file in any of the formats: text, binary, block compressed,
+ * or gzip compressed when its name ends in .gz */
+template <typename Container>
+bool parse_database_file(const std::string &file_name, Container &container, bool huge_pages=false) {
+	if(is_gzip_file(file_name)) {
+		gzip_reader reader(file_name);
+		return parse_database(reader, container);
+	}
+	
+	mapped_file file(file_name, huge_pages);
+	if(is_block_database(file.begin(), file.end())) {
+		return read_block_database(file.begin(), file.end(), container);
+	}
+	
+	return parse_database(file.begin(), file.end(), container);
+}
+
+#endif
@@ -0,0 +1,6 @@
+#include "pattern_mining.hh"
+#include "id_list_miner.hh"
+
+int main(int argc, char *argv[]) {
+	return run<id_list_miner>(argc, argv);
+}
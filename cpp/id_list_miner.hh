@@ -0,0 +1,325 @@
+#ifndef _ID_LIST_MINER_HH_
+#define _ID_LIST_MINER_HH_
+
+#include <iostream>
+#include <sstream>
+
+#include <list>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <algorithm>
+#include <iterator>
+
+#include "ordered_set.hh"
+#include "sequence.hh"
+#include "flat_database.hh"
+#include "sequential_pattern_miner.hh"
+
+/* vertical (SPADE style) miner
+ *
+ * the database is converted once into one id-list per frequent item holding
+ * the (sequence id, position) of every occurrence, sorted by sequence id and
+ * position. patterns grow by joining the id-list of the prefix with the
+ * id-list of an item, and each node only tries the extensions that were
+ * frequent for its parent. */
+template <typename Value1, typename Value2>
+class id_list_miner : public sequential_pattern_miner<Value1,Value2> {
+	public:
+		using sequential_pattern_miner<Value1,Value2>::mine;
+		
+		virtual bool supports_cooccurrence_pruning() const {
+			return false;
+		}
+		
+		/* the id-lists are joined depth first without tasks */
+		virtual bool supports_threads() const {
+			return false;
+		}
+		
+		#ifndef NDEBUG
+		using sequential_pattern_miner<Value1,Value2>::update_graph;
+		#endif
+		
+	protected:
+		typedef std::vector<std::pair<unsigned int,unsigned int> > id_list;
+		
+		virtual void mine_patterns(std::vector<const sequence<Value1> *> &database, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<Value1> &return_patterns, pattern_sink<Value1> &) const {
+			#ifndef NDEBUG
+			std::cerr << __FILE__ << ":" << __LINE__ << std::endl;
+			#endif
+			
+			mine_vertical_patterns(database, items, min_support, return_patterns);
+		}
+		
+		virtual void mine_patterns(std::vector<const sequence_view<Value1> *> &database, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<Value1> &return_patterns, pattern_sink<Value1> &) const {
+			#ifndef NDEBUG
+			std::cerr << __FILE__ << ":" << __LINE__ << std::endl;
+			#endif
+			
+			mine_vertical_patterns(database, items, min_support, return_patterns);
+		}
+		
+	private:
+		/* number of distinct sequences in the id-list */
+		static unsigned int support(const id_list &list) {
+			unsigned int count = 0;
+			
+			id_list::const_iterator list_iter = list.begin();
+			for(; list_iter != list.end(); ++list_iter) {
+				if(list_iter == list.begin() || (list_iter-1)->first != list_iter->first) {
+					count++;
+				}
+			}
+			
+			return count;
+		}
+		
+		/* occurrences of item strictly after the earliest occurrence of the prefix in the same sequence */
+		static unsigned int temporal_join(const id_list &prefix, const id_list &item, id_list &result) {
+			unsigned int count = 0;
+			
+			id_list::const_iterator prefix_iter = prefix.begin();
+			id_list::const_iterator item_iter = item.begin();
+			while(prefix_iter != prefix.end() && item_iter != item.end()) {
+				if(prefix_iter->first < item_iter->first) {
+					++prefix_iter;
+				}
+				else if(item_iter->first < prefix_iter->first) {
+					++item_iter;
+				}
+				else {
+					unsigned int sequence_id = prefix_iter->first;
+					unsigned int position = prefix_iter->second;
+					
+					id_list::size_type size = result.size();
+					for(; item_iter != item.end() && item_iter->first == sequence_id; ++item_iter) {
+						if(item_iter->second > position) {
+							result.push_back(*item_iter);
+						}
+					}
+					
+					if(result.size() > size) {
+						count++;
+					}
+					
+					while(prefix_iter != prefix.end() && prefix_iter->first == sequence_id) {
+						++prefix_iter;
+					}
+				}
+			}
+			
+			return count;
+		}
+		
+		/* occurrences of item in the same itemset as the end of the prefix */
+		static unsigned int equality_join(const id_list &prefix, const id_list &item, id_list &result) {
+			unsigned int count = 0;
+			
+			id_list::const_iterator prefix_iter = prefix.begin();
+			id_list::const_iterator item_iter = item.begin();
+			while(prefix_iter != prefix.end() && item_iter != item.end()) {
+				if(*prefix_iter < *item_iter) {
+					++prefix_iter;
+				}
+				else if(*item_iter < *prefix_iter) {
+					++item_iter;
+				}
+				else {
+					if(result.empty() || result.back().first != prefix_iter->first) {
+						count++;
+					}
+					
+					result.push_back(*prefix_iter);
+					++prefix_iter;
+					++item_iter;
+				}
+			}
+			
+			return count;
+		}
+		
+		template <typename Sequence>
+		void mine_vertical_patterns(std::vector<const Sequence *> &database, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<Value2> &return_patterns) const {
+			std::vector<id_list> id_lists(items.size());
+			
+			for(unsigned int ii=0; ii < database.size(); ii++) {
+				unsigned int position = 0;
+				
+				typename Sequence::const_iterator seq_iter = database[ii]->begin();
+				for(; seq_iter != database[ii]->end(); ++seq_iter) {
+					unsigned int index = item_index(items, *seq_iter);
+					if(index < items.size()) {
+						id_lists[index].push_back(std::make_pair(ii, position++));
+					}
+				}
+			}
+			
+			std::vector<unsigned int> candidates;
+			for(unsigned int ii=0; ii < items.size(); ii++) {
+				if(support(id_lists[ii]) >= min_support) {
+					candidates.push_back(ii);
+				}
+			}
+			
+			sequence<Value2> seq;
+			std::vector<unsigned int>::iterator candidates_iter = candidates.begin();
+			for(; candidates_iter != candidates.end(); ++candidates_iter) {
+				seq.push_element(items[*candidates_iter]);
+				
+				#ifndef NDEBUG
+				update_graph(seq, items);
+				#endif
+				
+				mine_patterns(id_lists, id_lists[*candidates_iter], support(id_lists[*candidates_iter]), seq, candidates, items, min_support, return_patterns);
+				
+				seq.pop_element();
+			}
+		}
+		
+		template <typename Sequence>
+		void mine_vertical_patterns(std::vector<const Sequence *> &database, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<ordered_set<Value2> > &return_patterns) const {
+			typedef typename std::iterator_traits<typename Sequence::const_iterator>::value_type set_type;
+			
+			std::vector<id_list> id_lists(items.size());
+			
+			for(unsigned int ii=0; ii < database.size(); ii++) {
+				unsigned int position = 0;
+				
+				typename Sequence::const_iterator seq_iter = database[ii]->begin();
+				for(; seq_iter != database[ii]->end(); ++seq_iter, position++) {
+					const set_type &tmp_set = *seq_iter;
+					
+					typename set_type::const_iterator tmp_set_iter = tmp_set.begin();
+					for(; tmp_set_iter != tmp_set.end(); ++tmp_set_iter) {
+						unsigned int index = item_index(items, *tmp_set_iter);
+						if(index < items.size()) {
+							id_lists[index].push_back(std::make_pair(ii, position));
+						}
+					}
+				}
+			}
+			
+			std::vector<unsigned int> candidates;
+			for(unsigned int ii=0; ii < items.size(); ii++) {
+				if(support(id_lists[ii]) >= min_support) {
+					candidates.push_back(ii);
+				}
+			}
+			
+			sequence<ordered_set<Value2> > seq;
+			std::vector<unsigned int>::iterator candidates_iter = candidates.begin();
+			for(; candidates_iter != candidates.end(); ++candidates_iter) {
+				seq.push_element(ordered_set<Value2>());
+				seq.push_item(items[*candidates_iter]);
+				
+				#ifndef NDEBUG
+				update_graph(seq, items);
+				#endif
+				
+				std::vector<unsigned int> item_candidates(candidates_iter+1, candidates.end());
+				mine_patterns(id_lists, id_lists[*candidates_iter], support(id_lists[*candidates_iter]), seq, item_candidates, candidates, items, min_support, return_patterns);
+				
+				seq.pop_element();
+			}
+		}
+		
+		void mine_patterns(const std::vector<id_list> &id_lists, const id_list &prefix, unsigned int prefix_support, sequence<Value2> &seq, const std::vector<unsigned int> &candidates, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<Value2> &return_patterns) const {
+			maintain_and_test(seq, prefix_support, return_patterns);
+			
+			std::vector<id_list> extensions;
+			std::vector<unsigned int> extension_supports;
+			std::vector<unsigned int> frequent_candidates;
+			
+			std::vector<unsigned int>::const_iterator candidates_iter = candidates.begin();
+			for(; candidates_iter != candidates.end(); ++candidates_iter) {
+				id_list extension;
+				unsigned int extension_support = temporal_join(prefix, id_lists[*candidates_iter], extension);
+				if(extension_support >= min_support) {
+					extensions.push_back(id_list());
+					extensions.back().swap(extension);
+					extension_supports.push_back(extension_support);
+					frequent_candidates.push_back(*candidates_iter);
+				}
+			}
+			
+			for(unsigned int ii=0; ii < frequent_candidates.size(); ii++) {
+				seq.push_element(items[frequent_candidates[ii]]);
+				
+				#ifndef NDEBUG
+				update_graph(seq, items);
+				#endif
+				
+				mine_patterns(id_lists, extensions[ii], extension_supports[ii], seq, frequent_candidates, items, min_support, return_patterns);
+				
+				seq.pop_element();
+			}
+		}
+		
+		/* item_candidates extend the last itemset of seq, element_candidates start a new one */
+		void mine_patterns(const std::vector<id_list> &id_lists, const id_list &prefix, unsigned int prefix_support, sequence<ordered_set<Value2> > &seq, const std::vector<unsigned int> &item_candidates, const std::vector<unsigned int> &element_candidates, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<ordered_set<Value2> > &return_patterns) const {
+			maintain_and_test(seq, prefix_support, return_patterns);
+			
+			std::vector<id_list> item_extensions;
+			std::vector<unsigned int> item_supports;
+			std::vector<unsigned int> frequent_items;
+			
+			std::vector<unsigned int>::const_iterator candidates_iter = item_candidates.begin();
+			for(; candidates_iter != item_candidates.end(); ++candidates_iter) {
+				id_list extension;
+				unsigned int extension_support = equality_join(prefix, id_lists[*candidates_iter], extension);
+				if(extension_support >= min_support) {
+					item_extensions.push_back(id_list());
+					item_extensions.back().swap(extension);
+					item_supports.push_back(extension_support);
+					frequent_items.push_back(*candidates_iter);
+				}
+			}
+			
+			std::vector<id_list> element_extensions;
+			std::vector<unsigned int> element_supports;
+			std::vector<unsigned int> frequent_elements;
+			
+			candidates_iter = element_candidates.begin();
+			for(; candidates_iter != element_candidates.end(); ++candidates_iter) {
+				id_list extension;
+				unsigned int extension_support = temporal_join(prefix, id_lists[*candidates_iter], extension);
+				if(extension_support >= min_support) {
+					element_extensions.push_back(id_list());
+					element_extensions.back().swap(extension);
+					element_supports.push_back(extension_support);
+					frequent_elements.push_back(*candidates_iter);
+				}
+			}
+			
+			for(unsigned int ii=0; ii < frequent_items.size(); ii++) {
+				seq.push_item(items[frequent_items[ii]]);
+				
+				#ifndef NDEBUG
+				update_graph(seq, items);
+				#endif
+				
+				std::vector<unsigned int> next_item_candidates(frequent_items.begin()+ii+1, frequent_items.end());
+				mine_patterns(id_lists, item_extensions[ii], item_supports[ii], seq, next_item_candidates, frequent_elements, items, min_support, return_patterns);
+				
+				seq.pop_item();
+			}
+			
+			for(unsigned int ii=0; ii < frequent_elements.size(); ii++) {
+				seq.push_element(ordered_set<Value2>());
+				seq.push_item(items[frequent_elements[ii]]);
+				
+				#ifndef NDEBUG
+				update_graph(seq, items);
+				#endif
+				
+				std::vector<unsigned int> next_item_candidates(frequent_elements.begin()+ii+1, frequent_elements.end());
+				mine_patterns(id_lists, element_extensions[ii], element_supports[ii], seq, next_item_candidates, frequent_elements, items, min_support, return_patterns);
+				
+				seq.pop_element();
+			}
+		}
+};
+
+#endif
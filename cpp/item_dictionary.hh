@@ -0,0 +1,153 @@
+#ifndef _ITEM_DICTIONARY_HH_
+#define _ITEM_DICTIONARY_HH_
+
+#include <iostream>
+#include <sstream>
+
+#include <set>
+#include <vector>
+
+#include <algorithm>
+
+#include <stdexcept>
+
+#include "ordered_set.hh"
+#include "sequence.hh"
+
+/* the item type T stands in for when mining encoded Value elements,
+ * i.e., std::string for int and ordered_set<std::string> for ordered_set<int> */
+template <typename T, typename Value>
+struct decoded_value {
+	typedef T type;
+};
+
+template <typename T, typename Value>
+struct decoded_value<T,ordered_set<Value> > {
+	typedef ordered_set<T> type;
+};
+
+/* maps items to dense integer ids
+ *
+ * ids are assigned in sorted item order, so comparing two encoded
+ * sequences gives the same result as comparing the original sequences */
+template <typename T>
+class item_dictionary {
+	public:
+		typedef typename std::vector<T>::size_type size_type;
+		typedef typename std::vector<T>::const_iterator const_iterator;
+		
+		item_dictionary() : items() {
+			
+		}
+		
+		const_iterator begin() const {
+			return items.begin();
+		}
+		
+		const_iterator end() const {
+			return items.end();
+		}
+		
+		size_type size() const {
+			return items.size();
+		}
+		
+		bool empty() const {
+			return items.empty();
+		}
+		
+		void clear() {
+			items.clear();
+		}
+		
+		/* add the items of every sequence in the database, renumbering all ids */
+		template <template <typename, typename> class Container, typename Value, typename Alloc>
+		void insert(const Container<sequence<Value>, Alloc> &database) {
+			std::set<T> tmp_items(items.begin(), items.end());
+			
+			typename Container<sequence<Value>, Alloc>::const_iterator database_iter = database.begin();
+			for(; database_iter != database.end(); ++database_iter) {
+				extract_items(*database_iter, tmp_items);
+			}
+			
+			std::vector<T> tmp_vector(tmp_items.begin(), tmp_items.end());
+			items.swap(tmp_vector);
+		}
+		
+		int encode(const T &item) const {
+			const_iterator iter = std::lower_bound(items.begin(), items.end(), item);
+			if(iter == items.end() || item < *iter) {
+				std::ostringstream oss;
+				oss << "item '" << item << "' not found in dictionary";
+				throw std::out_of_range(oss.str());
+			}
+			
+			return (int) std::distance(items.begin(), iter);
+		}
+		
+		const T & decode(int id) const {
+			return items[id];
+		}
+		
+		void encode(const sequence<T> &seq, sequence<int> &result) const {
+			result.clear();
+			
+			typename sequence<T>::const_iterator seq_iter = seq.begin();
+			for(; seq_iter != seq.end(); ++seq_iter) {
+				result.push_element(encode(*seq_iter));
+			}
+		}
+		
+		void encode(const sequence<ordered_set<T> > &seq, sequence<ordered_set<int> > &result) const {
+			result.clear();
+			
+			typename sequence<ordered_set<T> >::const_iterator seq_iter = seq.begin();
+			for(; seq_iter != seq.end(); ++seq_iter) {
+				result.push_element(ordered_set<int>());
+				
+				typename ordered_set<T>::const_iterator set_iter = seq_iter->begin();
+				for(; set_iter != seq_iter->end(); ++set_iter) {
+					result.push_item(encode(*set_iter));
+				}
+			}
+		}
+		
+		void decode(const sequence<int> &seq, sequence<T> &result) const {
+			result.clear();
+			
+			sequence<int>::const_iterator seq_iter = seq.begin();
+			for(; seq_iter != seq.end(); ++seq_iter) {
+				result.push_element(decode(*seq_iter));
+			}
+		}
+		
+		void decode(const sequence<ordered_set<int> > &seq, sequence<ordered_set<T> > &result) const {
+			result.clear();
+			
+			sequence<ordered_set<int> >::const_iterator seq_iter = seq.begin();
+			for(; seq_iter != seq.end(); ++seq_iter) {
+				result.push_element(ordered_set<T>());
+				
+				ordered_set<int>::const_iterator set_iter = seq_iter->begin();
+				for(; set_iter != seq_iter->end(); ++set_iter) {
+					result.push_item(decode(*set_iter));
+				}
+			}
+		}
+		
+	protected:
+		static void extract_items(const sequence<T> &seq, std::set<T> &itemset) {
+			itemset.insert(seq.begin(), seq.end());
+		}
+		
+		static void extract_items(const sequence<ordered_set<T> > &seq, std::set<T> &itemset) {
+			typename sequence<ordered_set<T> >::const_iterator seq_iter = seq.begin();
+			for(; seq_iter != seq.end(); ++seq_iter) {
+				itemset.insert(seq_iter->begin(), seq_iter->end());
+			}
+		}
+		
+		std::vector<T> items;
+};
+
+#endif
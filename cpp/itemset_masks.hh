@@ -0,0 +1,73 @@
+#ifndef _ITEMSET_MASKS_HH_
+#define _ITEMSET_MASKS_HH_
+
+#include <vector>
+
+#include <algorithm>
+
+#include <climits>
+#include <cstddef>
+
+/* itemsets as bit masks over a dense alphabet
+ *
+ * the items of the alphabet are numbered by their place in a sorted list and
+ * an itemset becomes words() words with the bits of its items set, so testing
+ * whether one itemset holds another is an and per word instead of a merge of
+ * two sorted lists. items outside the alphabet are dropped. */
+template <typename T>
+class itemset_masks {
+	public:
+		typedef unsigned long word_type;
+		
+		static const std::size_t word_bits = sizeof(word_type) * CHAR_BIT;
+		
+		explicit itemset_masks(const std::vector<T> &alphabet) : alphabet(alphabet), mask_words(std::max<std::size_t>(1, (alphabet.size() + word_bits - 1) / word_bits)) {
+			
+		}
+		
+		/* words in the mask of an itemset */
+		std::size_t words() const {
+			return mask_words;
+		}
+		
+		/* appends the mask of the sorted items of set to masks */
+		template <typename Set>
+		void add(const Set &set, std::vector<word_type> &masks) const {
+			std::size_t offset = masks.size();
+			masks.resize(offset + mask_words, 0);
+			
+			typename std::vector<T>::const_iterator alphabet_iter = alphabet.begin();
+			typename Set::const_iterator set_iter = set.begin();
+			for(; set_iter != set.end(); ++set_iter) {
+				alphabet_iter = std::lower_bound(alphabet_iter, alphabet.end(), *set_iter);
+				if(alphabet_iter == alphabet.end()) {
+					break;
+				}
+				
+				if(!(*set_iter < *alphabet_iter)) {
+					std::size_t bit = alphabet_iter - alphabet.begin();
+					masks[offset + bit / word_bits] |= word_type(1) << (bit % word_bits);
+				}
+			}
+		}
+		
+		/* whether every item of the mask sub is in the mask super */
+		bool subset(const word_type *sub, const word_type *super) const {
+			for(std::size_t ii=0; ii < mask_words; ii++) {
+				if(sub[ii] & ~super[ii]) {
+					return false;
+				}
+			}
+			
+			return true;
+		}
+		
+	private:
+		std::vector<T> alphabet;
+		std::size_t mask_words;
+};
+
+template <typename T>
+const std::size_t itemset_masks<T>::word_bits;
+
+#endif
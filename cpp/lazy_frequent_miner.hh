@@ -23,13 +23,30 @@ class lazy_frequent : public sequential_pattern_miner<Value1,Value2> {
 	public:
 		using sequential_pattern_miner<Value1,Value2>::mine;
 		
+		virtual bool supports_local_counting() const {
+			return true;
+		}
+		
 		#ifndef NDEBUG
 		using sequential_pattern_miner<Value1,Value2>::update_graph;
 		#endif
 		
 	protected:
+		using sequential_pattern_miner<Value1,Value2>::spawn_tasks;
+		using sequential_pattern_miner<Value1,Value2>::create_task;
+		using sequential_pattern_miner<Value1,Value2>::merge_tasks;
+		using sequential_pattern_miner<Value1,Value2>::cooccurrences;
+		using sequential_pattern_miner<Value1,Value2>::local_counting;
 		
-		virtual void mine_patterns(std::vector<const sequence<Value1> *> &database, const std::vector<Value2> &items, unsigned int min_support, std::map<unsigned int,std::list<sequence<Value1> > > &return_patterns) const {
+		virtual void mine_patterns(std::vector<const sequence<Value1> *> &database, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<Value1> &return_patterns, pattern_sink<Value1> &) const {
+			#ifndef NDEBUG
+			std::cerr << __FILE__ << ":" << __LINE__ << std::endl;
+			#endif
+			
+			mine_patterns(database.begin(), database.end(), items, min_support, return_patterns);
+		}
+		
+		virtual void mine_patterns(std::vector<const sequence_view<Value1> *> &database, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<Value1> &return_patterns, pattern_sink<Value1> &) const {
 			#ifndef NDEBUG
 			std::cerr << __FILE__ << ":" << __LINE__ << std::endl;
 			#endif
@@ -38,15 +55,65 @@ class lazy_frequent : public sequential_pattern_miner<Value1,Value2> {
 		}
 		
 	private:
-		void mine_patterns(typename std::vector<const sequence<Value2> *>::iterator db_begin, typename std::vector<const sequence<Value2> *>::iterator db_end, sequence<Value2> &seq, const std::vector<Value2> &items, unsigned int min_support, std::map<unsigned int,std::list<sequence<Value2> > > &return_patterns) const {
+		/* the candidates that occur after seq in at least min_support of the
+		 * projected sequences, counted before trying any of them */
+		template <typename Iter>
+		void count_local_items(Iter db_begin, Iter db_end, const sequence<Value2> &seq, const std::vector<Value2> &items, unsigned int min_support, std::vector<Value2> &frequent_items) const {
+			local_item_counter<Value2> counter(items);
+			for(; db_begin != db_end; ++db_begin) {
+				count_extensions(**db_begin, seq, counter);
+			}
+			
+			local_frequent_items(items, counter, min_support, frequent_items);
+		}
+		
+		/* for itemsets, the candidates to grow the last element of seq, the
+		 * candidates for a new element, and the items that are either */
+		template <typename Iter>
+		void count_local_items(Iter db_begin, Iter db_end, const sequence<ordered_set<Value2> > &seq, const std::vector<Value2> &items, unsigned int min_support, std::vector<Value2> &set_items, std::vector<Value2> &frequent_items, std::vector<Value2> &local_items) const {
+			local_item_counter<Value2> set_counter(items), sequence_counter(items);
+			for(; db_begin != db_end; ++db_begin) {
+				count_extensions(**db_begin, seq, set_counter, sequence_counter);
+			}
+			
+			local_frequent_items(items, set_counter, min_support, set_items);
+			local_frequent_items(items, sequence_counter, min_support, frequent_items);
+			
+			local_items.clear();
+			typename std::vector<Value2>::const_iterator items_iter = items.begin();
+			for(; items_iter != items.end(); ++items_iter) {
+				if(set_counter.frequent(*items_iter, min_support) || sequence_counter.frequent(*items_iter, min_support)) {
+					local_items.push_back(*items_iter);
+				}
+			}
+		}
+		
+		template <typename Iter>
+		void mine_patterns(Iter db_begin, Iter db_end, sequence<Value2> &seq, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<Value2> &return_patterns) const {
 			//std::cout << std::distance(db_begin, db_end) << " " << seq << std::endl;
 			maintain_and_test(seq, std::distance(db_begin, db_end), return_patterns);
 			
-			std::vector<Value2> frequent_items(items);
+			std::vector<Value2> frequent_items;
+			if(local_counting) {
+				count_local_items(db_begin, db_end, seq, items, min_support, frequent_items);
+			}
+			else {
+				frequent_items = items;
+			}
 			
-			typename std::vector<const sequence<Value2> *>::iterator end_iter;
+			typedef typename sequential_pattern_miner<Value1,Value2>::template mining_task<Iter,Value2> task_type;
+			std::list<task_type> tasks;
+			bool spawn = spawn_tasks(db_begin, db_end);
+			
+			Iter end_iter;
 			typename std::vector<Value2>::iterator frequent_items_iter = frequent_items.begin();
 			while(frequent_items_iter != frequent_items.end()) {
+				if(!cooccurrences.sequence_extension(seq.last(), *frequent_items_iter)) {
+					std::swap(*frequent_items_iter, frequent_items.back());
+					frequent_items.pop_back();
+					continue;
+				}
+				
 				seq.push_element(*frequent_items_iter);
 				
 				//end_iter = std::partition(db_begin, db_end, is_subsequence<Value2>(seq));
@@ -57,7 +124,14 @@ class lazy_frequent : public sequential_pattern_miner<Value1,Value2> {
 					update_graph(seq, frequent_items);
 					#endif
 					
-					mine_patterns(db_begin, end_iter, seq, frequent_items, min_support, return_patterns);
+					if(spawn) {
+						task_type *task = create_task(tasks, db_begin, end_iter, seq, frequent_items);
+						#pragma omp task firstprivate(task, min_support)
+						mine_patterns(task->database.begin(), task->database.end(), task->seq, task->items, min_support, task->patterns);
+					}
+					else {
+						mine_patterns(db_begin, end_iter, seq, frequent_items, min_support, return_patterns);
+					}
 					++frequent_items_iter;
 				}
 				else {
@@ -67,12 +141,19 @@ class lazy_frequent : public sequential_pattern_miner<Value1,Value2> {
 				
 				seq.pop_element();
 			}
+			
+			merge_tasks(tasks, return_patterns);
 		}
 		
-		void mine_patterns(typename std::vector<const sequence<Value2> *>::iterator db_begin, typename std::vector<const sequence<Value2> *>::iterator db_end, const std::vector<Value2> &items, unsigned int min_support, std::map<unsigned int,std::list<sequence<Value2> > > &return_patterns) const {
+		template <typename Iter>
+		void mine_patterns(Iter db_begin, Iter db_end, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<Value2> &return_patterns) const {
 			sequence<Value2> seq;
 			
-			typename std::vector<const sequence<Value2> *>::iterator end_iter;
+			typedef typename sequential_pattern_miner<Value1,Value2>::template mining_task<Iter,Value2> task_type;
+			std::list<task_type> tasks;
+			bool spawn = spawn_tasks(db_begin, db_end);
+			
+			Iter end_iter;
 			typename std::vector<Value2>::const_iterator items_iter = items.begin();
 			while(items_iter != items.end()) {
 				seq.push_element(*items_iter);
@@ -84,41 +165,78 @@ class lazy_frequent : public sequential_pattern_miner<Value1,Value2> {
 				update_graph(seq, items);
 				#endif
 				
-				mine_patterns(db_begin, end_iter, seq, items, min_support, return_patterns);
+				if(spawn) {
+					task_type *task = create_task(tasks, db_begin, end_iter, seq, items);
+					#pragma omp task firstprivate(task, min_support)
+					mine_patterns(task->database.begin(), task->database.end(), task->seq, task->items, min_support, task->patterns);
+				}
+				else {
+					mine_patterns(db_begin, end_iter, seq, items, min_support, return_patterns);
+				}
 				++items_iter;
 				
 				seq.pop_element();
 			}
+			
+			merge_tasks(tasks, return_patterns);
 		}
 		
-		void mine_patterns(typename std::vector<const sequence<ordered_set<Value2> > *>::iterator db_begin, typename std::vector<const sequence<ordered_set<Value2> > *>::iterator db_end, sequence<ordered_set<Value2> > &seq, const std::vector<Value2> &items, unsigned int min_support, std::map<unsigned int,std::list<sequence<ordered_set<Value2> > > > &return_patterns) const {
+		template <typename Iter>
+		void mine_patterns(Iter db_begin, Iter db_end, sequence<ordered_set<Value2> > &seq, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<ordered_set<Value2> > &return_patterns) const {
 			//std::cout << std::distance(db_begin, db_end) << " " << seq << std::endl;
 			maintain_and_test(seq, std::distance(db_begin, db_end), return_patterns);
 			
-			typename std::vector<const sequence<ordered_set<Value2> > *>::iterator end_iter;
-			typename std::vector<Value2>::const_iterator items_iter = items.begin();
-			for(; items_iter != items.end(); ++items_iter) {
-				if(seq.push_item(*items_iter)) {
+			std::vector<Value2> set_items, frequent_items, local_items;
+			if(local_counting) {
+				count_local_items(db_begin, db_end, seq, items, min_support, set_items, frequent_items, local_items);
+			}
+			else {
+				frequent_items = items;
+			}
+			
+			const std::vector<Value2> &extension_items = local_counting ? set_items : items;
+			const std::vector<Value2> &child_items = local_counting ? local_items : items;
+			
+			typedef typename sequential_pattern_miner<Value1,Value2>::template mining_task<Iter,ordered_set<Value2> > task_type;
+			std::list<task_type> tasks;
+			bool spawn = spawn_tasks(db_begin, db_end);
+			
+			Iter end_iter;
+			typename std::vector<Value2>::const_iterator items_iter = extension_items.begin();
+			for(; items_iter != extension_items.end(); ++items_iter) {
+				if(cooccurrences.set_extension(seq.last().get_element(), *items_iter) && seq.push_item(*items_iter)) {
 					//end_iter = std::partition(db_begin, db_end, is_subsequence<Value1>(seq));
 					end_iter = project_database(db_begin, db_end, is_subsequence<Value1>(seq), min_support);
 					
 					if(std::distance(db_begin, end_iter) >= min_support) {
 						#ifndef NDEBUG
-						update_graph(seq, items);
+						update_graph(seq, child_items);
 						#endif
 						
-						mine_patterns(db_begin, end_iter, seq, items, min_support, return_patterns);
+						if(spawn) {
+							task_type *task = create_task(tasks, db_begin, end_iter, seq, child_items);
+							#pragma omp task firstprivate(task, min_support)
+							mine_patterns(task->database.begin(), task->database.end(), task->seq, task->items, min_support, task->patterns);
+						}
+						else {
+							mine_patterns(db_begin, end_iter, seq, child_items, min_support, return_patterns);
+						}
 					}
 					
 					seq.pop_item();
 				}
 			}
 			
-			std::vector<Value2> frequent_items(items);
-			
+			Value2 last_item = seq.last().get_element();
 			seq.push_element(ordered_set<Value2>());
 			typename std::vector<Value2>::iterator frequent_items_iter = frequent_items.begin();
 			while(frequent_items_iter != frequent_items.end()) {
+				if(!cooccurrences.sequence_extension(last_item, *frequent_items_iter)) {
+					std::swap(*frequent_items_iter, frequent_items.back());
+					frequent_items.pop_back();
+					continue;
+				}
+				
 				seq.push_item(*frequent_items_iter);
 				
 				//end_iter = std::partition(db_begin, db_end, is_subsequence<Value1>(seq));
@@ -129,7 +247,14 @@ class lazy_frequent : public sequential_pattern_miner<Value1,Value2> {
 					update_graph(seq, frequent_items);
 					#endif
 					
-					mine_patterns(db_begin, end_iter, seq, frequent_items, min_support, return_patterns);
+					if(spawn) {
+						task_type *task = create_task(tasks, db_begin, end_iter, seq, frequent_items);
+						#pragma omp task firstprivate(task, min_support)
+						mine_patterns(task->database.begin(), task->database.end(), task->seq, task->items, min_support, task->patterns);
+					}
+					else {
+						mine_patterns(db_begin, end_iter, seq, frequent_items, min_support, return_patterns);
+					}
 					++frequent_items_iter;
 				}
 				else {
@@ -140,13 +265,20 @@ class lazy_frequent : public sequential_pattern_miner<Value1,Value2> {
 				seq.pop_item();
 			}
 			seq.pop_element();
+			
+			merge_tasks(tasks, return_patterns);
 		}
 		
-		void mine_patterns(typename std::vector<const sequence<ordered_set<Value2> > *>::iterator db_begin, typename std::vector<const sequence<ordered_set<Value2> > *>::iterator db_end, const std::vector<Value2> &items, unsigned int min_support, std::map<unsigned int,std::list<sequence<ordered_set<Value2> > > > &return_patterns) const {
+		template <typename Iter>
+		void mine_patterns(Iter db_begin, Iter db_end, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<ordered_set<Value2> > &return_patterns) const {
 			sequence<ordered_set<Value2> > seq;
 			seq.push_element(ordered_set<Value2>());
 			
-			typename std::vector<const sequence<ordered_set<Value2> > *>::iterator end_iter;
+			typedef typename sequential_pattern_miner<Value1,Value2>::template mining_task<Iter,ordered_set<Value2> > task_type;
+			std::list<task_type> tasks;
+			bool spawn = spawn_tasks(db_begin, db_end);
+			
+			Iter end_iter;
 			typename std::vector<Value2>::const_iterator items_iter = items.begin();
 			while(items_iter != items.end()) {
 				seq.push_item(*items_iter);
@@ -158,13 +290,22 @@ class lazy_frequent : public sequential_pattern_miner<Value1,Value2> {
 				update_graph(seq, items);
 				#endif
 				
-				mine_patterns(db_begin, end_iter, seq, items, min_support, return_patterns);
+				if(spawn) {
+					task_type *task = create_task(tasks, db_begin, end_iter, seq, items);
+					#pragma omp task firstprivate(task, min_support)
+					mine_patterns(task->database.begin(), task->database.end(), task->seq, task->items, min_support, task->patterns);
+				}
+				else {
+					mine_patterns(db_begin, end_iter, seq, items, min_support, return_patterns);
+				}
 				++items_iter;
 				
 				seq.pop_item();
 			}
 			
 			seq.pop_element();
+			
+			merge_tasks(tasks, return_patterns);
 		}
 		
 };
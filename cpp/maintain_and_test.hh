@@ -6,6 +6,13 @@
 
 #include <map>
 #include <list>
+#include <string>
+
+#include <functional>
+
+#include <cstddef>
+
+#include <stdint.h>
 
 template <typename T>
 void maintain_and_test(const sequence<T> &seq, unsigned int support, std::map<unsigned int,std::list<sequence<T> > > &patterns) {
@@ -44,4 +51,203 @@ void maintain_and_test(const sequence<T> &seq, unsigned int support, std::map<un
 	}
 }
 
+/* signature bit of an item, items of other types all share one bit */
+template <typename T>
+uint64_t item_signature(const T &item) {
+	return 1;
+}
+
+inline uint64_t item_signature(int item) {
+	return ((uint64_t) 1) << ((unsigned int) item % 64);
+}
+
+inline uint64_t item_signature(const std::string &item) {
+	unsigned int hash = 0;
+	
+	std::string::const_iterator item_iter = item.begin();
+	for(; item_iter != item.end(); ++item_iter) {
+		hash = 31 * hash + (unsigned char) *item_iter;
+	}
+	
+	return ((uint64_t) 1) << (hash % 64);
+}
+
+template <typename T>
+void sequence_signature(const sequence<T> &seq, uint64_t &signature, std::size_t &items) {
+	signature = 0;
+	items = seq.length();
+	
+	typename sequence<T>::const_iterator seq_iter = seq.begin();
+	for(; seq_iter != seq.end(); ++seq_iter) {
+		signature |= item_signature(*seq_iter);
+	}
+}
+
+template <typename T>
+void sequence_signature(const sequence<ordered_set<T> > &seq, uint64_t &signature, std::size_t &items) {
+	signature = 0;
+	items = 0;
+	
+	typename sequence<ordered_set<T> >::const_iterator seq_iter = seq.begin();
+	for(; seq_iter != seq.end(); ++seq_iter) {
+		items += seq_iter->size();
+		
+		typename ordered_set<T>::const_iterator set_iter = seq_iter->begin();
+		for(; set_iter != seq_iter->end(); ++set_iter) {
+			signature |= item_signature(*set_iter);
+		}
+	}
+}
+
+/* closed patterns with the same semantics as maintain_and_test
+ *
+ * patterns are grouped by support and then by length, and each one keeps a
+ * signature of its items and its item count. a pattern can only be a
+ * subsequence of another when its length, item count and signature are all
+ * covered by the other's, so subsequence only runs on those candidates. */
+template <typename T>
+class closed_pattern_store {
+	public:
+		typedef std::size_t size_type;
+		
+		closed_pattern_store() : patterns() {
+			
+		}
+		
+		/* adds seq unless a pattern with the same support contains it, removing the
+		 * patterns with the same support it contains, returns whether it was added */
+		bool insert(const sequence<T> &seq, unsigned int support) {
+			entry new_entry;
+			new_entry.seq = seq;
+			sequence_signature(seq, new_entry.signature, new_entry.items);
+			
+			size_type length = seq.length();
+			length_buckets &buckets = patterns[support];
+			
+			typename length_buckets::iterator buckets_iter = buckets.begin();
+			for(; buckets_iter != buckets.end() && buckets_iter->first >= length; ++buckets_iter) {
+				typename bucket::const_iterator bucket_iter = buckets_iter->second.begin();
+				for(; bucket_iter != buckets_iter->second.end(); ++bucket_iter) {
+					if(new_entry.covered_by(*bucket_iter) && seq.subsequence(bucket_iter->seq)) {
+						return false;
+					}
+				}
+			}
+			
+			bucket &same_length = buckets[length];
+			same_length.push_front(new_entry);
+			
+			buckets_iter = buckets.find(length);
+			while(buckets_iter != buckets.end()) {
+				bucket &tmp_bucket = buckets_iter->second;
+				
+				typename bucket::iterator bucket_iter = tmp_bucket.begin();
+				if(buckets_iter->first == length) {
+					++bucket_iter;
+				}
+				
+				while(bucket_iter != tmp_bucket.end()) {
+					if(bucket_iter->covered_by(new_entry) && bucket_iter->seq.subsequence(seq)) {
+						bucket_iter = tmp_bucket.erase(bucket_iter);
+					}
+					else {
+						++bucket_iter;
+					}
+				}
+				
+				if(tmp_bucket.empty()) {
+					buckets.erase(buckets_iter++);
+				}
+				else {
+					++buckets_iter;
+				}
+			}
+			
+			return true;
+		}
+		
+		/* adds the patterns of other, oldest first, as if they had been inserted here */
+		void merge(const closed_pattern_store &other) {
+			typename std::map<unsigned int,length_buckets>::const_iterator patterns_iter = other.patterns.begin();
+			for(; patterns_iter != other.patterns.end(); ++patterns_iter) {
+				typename length_buckets::const_iterator buckets_iter = patterns_iter->second.begin();
+				for(; buckets_iter != patterns_iter->second.end(); ++buckets_iter) {
+					typename bucket::const_reverse_iterator bucket_iter = buckets_iter->second.rbegin();
+					for(; bucket_iter != buckets_iter->second.rend(); ++bucket_iter) {
+						insert(bucket_iter->seq, patterns_iter->first);
+					}
+				}
+			}
+		}
+		
+		/* appends the patterns in the order maintain_and_test keeps them: by
+		 * support, then longest first, then most recently added first */
+		void get_patterns(std::map<unsigned int,std::list<sequence<T> > > &return_patterns) const {
+			typename std::map<unsigned int,length_buckets>::const_iterator patterns_iter = patterns.begin();
+			for(; patterns_iter != patterns.end(); ++patterns_iter) {
+				std::list<sequence<T> > &sequences = return_patterns[patterns_iter->first];
+				
+				typename length_buckets::const_iterator buckets_iter = patterns_iter->second.begin();
+				for(; buckets_iter != patterns_iter->second.end(); ++buckets_iter) {
+					typename bucket::const_iterator bucket_iter = buckets_iter->second.begin();
+					for(; bucket_iter != buckets_iter->second.end(); ++bucket_iter) {
+						sequences.push_back(bucket_iter->seq);
+					}
+				}
+			}
+		}
+		
+		/* hands the patterns to sink in the order of get_patterns, releasing each
+		 * support's patterns once they have been written */
+		template <typename Sink>
+		void drain(Sink &sink) {
+			while(!patterns.empty()) {
+				typename std::map<unsigned int,length_buckets>::iterator patterns_iter = patterns.begin();
+				
+				typename length_buckets::const_iterator buckets_iter = patterns_iter->second.begin();
+				for(; buckets_iter != patterns_iter->second.end(); ++buckets_iter) {
+					typename bucket::const_iterator bucket_iter = buckets_iter->second.begin();
+					for(; bucket_iter != buckets_iter->second.end(); ++bucket_iter) {
+						sink.write(bucket_iter->seq, patterns_iter->first);
+					}
+				}
+				
+				patterns.erase(patterns_iter);
+			}
+		}
+		
+		bool empty() const {
+			return patterns.empty();
+		}
+		
+		void clear() {
+			patterns.clear();
+		}
+		
+		void swap(closed_pattern_store &other) {
+			patterns.swap(other.patterns);
+		}
+		
+	protected:
+		struct entry {
+			sequence<T> seq;
+			uint64_t signature;
+			size_type items;
+			
+			bool covered_by(const entry &other) const {
+				return items <= other.items && (signature & ~other.signature) == 0;
+			}
+		};
+		
+		typedef std::list<entry> bucket;
+		typedef std::map<size_type,bucket,std::greater<size_type> > length_buckets;
+		
+		std::map<unsigned int,length_buckets> patterns;
+};
+
+template <typename T>
+void maintain_and_test(const sequence<T> &seq, unsigned int support, closed_pattern_store<T> &patterns) {
+	patterns.insert(seq, support);
+}
+
 #endif
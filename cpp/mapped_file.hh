@@ -0,0 +1,128 @@
+#ifndef _MAPPED_FILE_HH_
+#define _MAPPED_FILE_HH_
+
+#include <sstream>
+
+#include <string>
+#include <vector>
+
+#include <stdexcept>
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* read-only view of a whole input file
+ *
+ * regular files are mapped into memory and advised for sequential access, so
+ * parsing reads straight from the page cache. anything that cannot be mapped
+ * (pipes, empty files) is read into a buffer instead. */
+class mapped_file {
+	public:
+		/* huge_pages asks the kernel to back the mapping with huge pages where it can */
+		mapped_file(const std::string &file_name, bool huge_pages=false) : data(NULL), size(0), mapped(false), buffer() {
+			int fd = open(file_name.c_str(), O_RDONLY);
+			if(fd < 0) {
+				throw_error(file_name);
+			}
+			
+			struct stat file_stat;
+			if(fstat(fd, &file_stat) < 0) {
+				int error = errno;
+				close(fd);
+				errno = error;
+				
+				throw_error(file_name);
+			}
+			
+			if(S_ISREG(file_stat.st_mode) && file_stat.st_size > 0) {
+				void *address = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if(address != MAP_FAILED) {
+					data = static_cast<const char *>(address);
+					size = file_stat.st_size;
+					mapped = true;
+					
+					madvise(address, size, MADV_SEQUENTIAL);
+					#ifdef MADV_HUGEPAGE
+					if(huge_pages) {
+						madvise(address, size, MADV_HUGEPAGE);
+					}
+					#endif
+				}
+			}
+			
+			if(!mapped && !read_file(fd)) {
+				int error = errno;
+				close(fd);
+				errno = error;
+				
+				throw_error(file_name);
+			}
+			
+			close(fd);
+		}
+		
+		~mapped_file() {
+			if(mapped) {
+				munmap(const_cast<char *>(data), size);
+			}
+		}
+		
+		const char * begin() const {
+			return data;
+		}
+		
+		const char * end() const {
+			return data + size;
+		}
+		
+		std::size_t length() const {
+			return size;
+		}
+		
+	private:
+		const char *data;
+		std::size_t size;
+		bool mapped;
+		std::vector<char> buffer;
+		
+		/* not copyable, the mapping is owned */
+		mapped_file(const mapped_file &);
+		mapped_file & operator=(const mapped_file &);
+		
+		bool read_file(int fd) {
+			buffer.resize(1 << 16);
+			
+			ssize_t count;
+			while((count = read(fd, &buffer[size], buffer.size() - size)) != 0) {
+				if(count < 0) {
+					if(errno == EINTR) {
+						continue;
+					}
+					
+					return false;
+				}
+				
+				size += count;
+				if(size == buffer.size()) {
+					buffer.resize(2 * size);
+				}
+			}
+			
+			data = &buffer[0];
+			return true;
+		}
+		
+		static void throw_error(const std::string &file_name) {
+			std::ostringstream oss;
+			oss <<  file_name << ": " << strerror(errno);
+			
+			throw std::runtime_error(oss.str());
+		}
+};
+
+#endif
@@ -110,7 +110,8 @@ class ordered_set {
 			return std::binary_search(begin(), end(), element);
 		}
 		
-		bool subset(const ordered_set &that) const {
+		template <typename Set>
+		bool subset(const Set &that) const {
 			/*const_iterator this_iter = begin();
 			const_iterator that_iter = that.begin();
 			while(this_iter != end()) {
@@ -134,7 +135,7 @@ class ordered_set {
 			return true;*/
 			
 			const_iterator this_iter = begin();
-			const_iterator that_iter = that.begin();
+			typename Set::const_iterator that_iter = that.begin();
 			while(this_iter != end() && that_iter != that.end()) {
 				if(*this_iter < *that_iter) {
 					return false;
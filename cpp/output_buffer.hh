@@ -0,0 +1,158 @@
+#ifndef _OUTPUT_BUFFER_HH_
+#define _OUTPUT_BUFFER_HH_
+
+#include <sstream>
+
+#include <string>
+#include <vector>
+
+#include <stdexcept>
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* write-only file with a large buffer and its own number formatting
+ *
+ * text is collected in memory and handed to the kernel in large writes, and
+ * integers are formatted by hand instead of through iostreams. */
+class output_buffer {
+	public:
+		output_buffer(const std::string &file_name, std::size_t buffer_size=1 << 22) : file_name(file_name), fd(-1), buffer(buffer_size), size(0) {
+			fd = open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+			if(fd < 0) {
+				throw_error();
+			}
+		}
+		
+		/* errors writing the rest of the buffer are ignored here, call close to see them */
+		~output_buffer() {
+			if(fd >= 0) {
+				write_buffer();
+				::close(fd);
+			}
+		}
+		
+		void put(char c) {
+			if(size == buffer.size()) {
+				flush();
+			}
+			
+			buffer[size++] = c;
+		}
+		
+		void put(const char *data, std::size_t length) {
+			if(length > buffer.size() - size) {
+				flush();
+				
+				if(length > buffer.size()) {
+					if(!write_data(data, length)) {
+						throw_error();
+					}
+					
+					return;
+				}
+			}
+			
+			std::memcpy(&buffer[size], data, length);
+			size += length;
+		}
+		
+		void put(const std::string &str) {
+			put(str.data(), str.size());
+		}
+		
+		void put(unsigned long value) {
+			char digits[3 * sizeof(unsigned long)];
+			char *position = digits + sizeof(digits);
+			
+			do {
+				*--position = '0' + value % 10;
+				value /= 10;
+			} while(value > 0);
+			
+			put(position, digits + sizeof(digits) - position);
+		}
+		
+		void put(long value) {
+			if(value < 0) {
+				put('-');
+				put(0ul - (unsigned long) value);
+			}
+			else {
+				put((unsigned long) value);
+			}
+		}
+		
+		void put(unsigned int value) {
+			put((unsigned long) value);
+		}
+		
+		void put(int value) {
+			put((long) value);
+		}
+		
+		void flush() {
+			if(!write_buffer()) {
+				throw_error();
+			}
+		}
+		
+		void close() {
+			flush();
+			
+			int result = ::close(fd);
+			fd = -1;
+			
+			if(result < 0) {
+				throw_error();
+			}
+		}
+		
+	private:
+		std::string file_name;
+		int fd;
+		std::vector<char> buffer;
+		std::size_t size;
+		
+		/* not copyable, the file is owned */
+		output_buffer(const output_buffer &);
+		output_buffer & operator=(const output_buffer &);
+		
+		bool write_buffer() {
+			std::size_t length = size;
+			size = 0;
+			
+			return length == 0 || write_data(&buffer[0], length);
+		}
+		
+		bool write_data(const char *data, std::size_t length) {
+			while(length > 0) {
+				ssize_t count = write(fd, data, length);
+				if(count < 0) {
+					if(errno == EINTR) {
+						continue;
+					}
+					
+					return false;
+				}
+				
+				data += count;
+				length -= count;
+			}
+			
+			return true;
+		}
+		
+		void throw_error() const {
+			std::ostringstream oss;
+			oss <<  file_name << ": " << strerror(errno);
+			
+			throw std::runtime_error(oss.str());
+		}
+};
+
+#endif
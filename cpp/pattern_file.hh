@@ -0,0 +1,532 @@
+#ifndef _PATTERN_FILE_HH_
+#define _PATTERN_FILE_HH_
+
+#include <sstream>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <stdexcept>
+
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+
+#include "ordered_set.hh"
+#include "sequence.hh"
+#include "sequence_parser.hh"
+#include "binary_database.hh"
+#include "item_dictionary.hh"
+#include "mapped_file.hh"
+#include "pattern_sink.hh"
+
+/* binary pattern file
+ *
+ * the result of a mining run with the support of every pattern, so later
+ * stages neither parse text nor recount supports. all fields are in native
+ * byte order, the version field doubles as a byte order check:
+ *   header      magic, version, flags, alphabet size, dictionary size
+ *   dictionary  for string items the dictionary section of the binary
+ *               database format, padded to 8 bytes, empty otherwise
+ *   patterns    per pattern uint32 support and uint32 element count, then
+ *               the elements
+ *
+ * with the pattern_trie flag the patterns are stored as a prefix tree
+ * instead, its nodes in depth first order each holding a single element:
+ *   nodes       per node depth, support and node flags, then the element
+ * where every field after the dictionary is a variable length integer. a
+ * node extends the path of nodes above it, so a pattern sharing a prefix
+ * with the one before only stores the elements after the prefix. nodes that
+ * are patterns themselves carry pattern_closed and their support, the other
+ * nodes are prefixes of later patterns and have support 0.
+ *
+ * an element is a single item, or for itemsets the number of items followed
+ * by the items. items are uint32 ids into the dictionary for string items and
+ * the int32 items themselves otherwise. patterns are written as they are
+ * mined, so the file has no index and is read front to back. */
+static const char pattern_file_magic[8] = { '\x89', 'S', 'E', 'Q', 'P', 'T', '\r', '\n' };
+static const uint32_t pattern_file_version = 1;
+
+/* header flags, next to binary_itemset and binary_strings */
+enum pattern_file_flags {
+	pattern_trie = 8
+};
+
+/* node flags of the prefix tree layout */
+enum pattern_node_flags {
+	pattern_closed = 1
+};
+
+struct pattern_file_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t flags;
+	uint64_t alphabet_size;
+	uint64_t dictionary_size;
+};
+
+inline bool is_pattern_file(const char *begin, const char *end) {
+	return end - begin >= (std::ptrdiff_t) sizeof(pattern_file_magic) && std::memcmp(begin, pattern_file_magic, sizeof(pattern_file_magic)) == 0;
+}
+
+inline bool is_pattern_file(const std::string &file_name) {
+	mapped_file file(file_name);
+	return is_pattern_file(file.begin(), file.end());
+}
+
+/* sequential reader over a binary pattern file held in memory */
+class pattern_file {
+	public:
+		pattern_file(const char *begin, const char *end) : header(), dictionary(NULL), position(NULL), end(end), path(), valid(false), failed(false) {
+			if(!is_pattern_file(begin, end) || end - begin < (std::ptrdiff_t) sizeof(pattern_file_header)) {
+				return;
+			}
+			
+			std::memcpy(&header, begin, sizeof(header));
+			if(header.version != pattern_file_version || header.dictionary_size > (uint64_t) (end - begin)) {
+				return;
+			}
+			
+			uint64_t offset = sizeof(header);
+			dictionary = begin + offset;
+			offset += (header.dictionary_size + 7) & ~((uint64_t) 7);
+			
+			position = begin + offset;
+			valid = offset <= (uint64_t) (end - begin);
+		}
+		
+		bool good() const {
+			return valid;
+		}
+		
+		bool itemset() const {
+			return header.flags & binary_itemset;
+		}
+		
+		bool strings() const {
+			return header.flags & binary_strings;
+		}
+		
+		bool trie() const {
+			return header.flags & pattern_trie;
+		}
+		
+		/* set once next has met a malformed pattern */
+		bool fail() const {
+			return failed;
+		}
+		
+		/* item values indexed by item id */
+		bool load_dictionary(std::vector<std::string> &values) const {
+			return strings() && load_string_dictionary(dictionary, header.alphabet_size, header.dictionary_size, values);
+		}
+		
+		/* numeric items are stored as they are, there is no dictionary to load */
+		template <typename T>
+		bool load_dictionary(std::vector<T> &values) const {
+			values.clear();
+			return !strings();
+		}
+		
+		/* reads the next pattern, returns false at the end of the file or on a
+		 * malformed pattern, in which case fail() is set. in the prefix tree
+		 * layout patterns are expanded from the path of nodes as they are read */
+		template <typename Value, typename T>
+		bool next(const std::vector<T> &values, sequence<Value> &seq, unsigned int &support) {
+			seq.clear();
+			
+			if(!valid || position == end) {
+				return false;
+			}
+			else if(itemset() != binary_is_itemset(seq)) {
+				return fail_pattern();
+			}
+			
+			return trie() ? next_node(values, seq, support) : next_pattern(values, seq, support);
+		}
+		
+	private:
+		pattern_file_header header;
+		const char *dictionary;
+		const char *position;
+		const char *end;
+		
+		/* start of the element of every node on the path to the current node */
+		std::vector<const char *> path;
+		
+		bool valid;
+		bool failed;
+		
+		template <typename Value, typename T>
+		bool next_pattern(const std::vector<T> &values, sequence<Value> &seq, unsigned int &support) {
+			uint32_t pattern_support, length;
+			if(!get(pattern_support) || !get(length)) {
+				return fail_pattern();
+			}
+			
+			for(uint32_t ii=0; ii < length; ii++) {
+				if(!get_element(values, seq)) {
+					return fail_pattern();
+				}
+			}
+			
+			support = pattern_support;
+			return true;
+		}
+		
+		template <typename Value, typename T>
+		bool next_node(const std::vector<T> &values, sequence<Value> &seq, unsigned int &support) {
+			while(position != end) {
+				uint32_t depth, node_support, node_flags;
+				if(!get(depth) || !get(node_support) || !get(node_flags) || depth == 0 || depth > path.size() + 1) {
+					return fail_pattern();
+				}
+				
+				path.resize(depth - 1);
+				path.push_back(position);
+				if(!skip_element()) {
+					return fail_pattern();
+				}
+				
+				if(node_flags & pattern_closed) {
+					const char *next_position = position;
+					
+					std::vector<const char *>::const_iterator path_iter = path.begin();
+					for(; path_iter != path.end(); ++path_iter) {
+						position = *path_iter;
+						if(!get_element(values, seq)) {
+							return fail_pattern();
+						}
+					}
+					
+					position = next_position;
+					support = node_support;
+					return true;
+				}
+			}
+			
+			return false;
+		}
+		
+		bool fail_pattern() {
+			failed = true;
+			return false;
+		}
+		
+		bool get(uint32_t &value) {
+			if(trie()) {
+				return get_varint(value);
+			}
+			else if(end - position < (std::ptrdiff_t) sizeof(value)) {
+				return false;
+			}
+			
+			std::memcpy(&value, position, sizeof(value));
+			position += sizeof(value);
+			
+			return true;
+		}
+		
+		/* seven bits per byte, low bits first, the high bit set on all but the last byte */
+		bool get_varint(uint32_t &value) {
+			value = 0;
+			for(unsigned int shift=0; position != end && shift < 32; shift += 7) {
+				unsigned char byte = *position++;
+				if(shift == 28 && (byte & 0x70) != 0) {
+					return false;
+				}
+				
+				value |= (uint32_t) (byte & 0x7f) << shift;
+				if((byte & 0x80) == 0) {
+					return true;
+				}
+			}
+			
+			return false;
+		}
+		
+		bool skip_element() {
+			uint32_t size = 1;
+			if(itemset() && !get(size)) {
+				return false;
+			}
+			
+			for(uint32_t ii=0; ii < size; ii++) {
+				uint32_t item;
+				if(!get(item)) {
+					return false;
+				}
+			}
+			
+			return true;
+		}
+		
+		template <typename T>
+		bool get_element(const std::vector<T> &values, sequence<T> &seq) {
+			T item;
+			if(!get_item(values, item)) {
+				return false;
+			}
+			
+			seq.push_element(item);
+			return true;
+		}
+		
+		template <typename T>
+		bool get_element(const std::vector<T> &values, sequence<ordered_set<T> > &seq) {
+			uint32_t size;
+			if(!get(size)) {
+				return false;
+			}
+			
+			seq.push_element(ordered_set<T>());
+			for(uint32_t ii=0; ii < size; ii++) {
+				T item;
+				if(!get_item(values, item) || !seq.push_item(item)) {
+					return false;
+				}
+			}
+			
+			return true;
+		}
+		
+		bool get_item(const std::vector<std::string> &values, std::string &item) {
+			uint32_t id;
+			if(!get(id) || id >= values.size()) {
+				return false;
+			}
+			
+			item = values[id];
+			return true;
+		}
+		
+		template <typename T>
+		bool get_item(const std::vector<T> &, T &item) {
+			uint32_t value;
+			if(!get(value)) {
+				return false;
+			}
+			
+			item = (T) (int32_t) value;
+			return true;
+		}
+};
+
+/* writes patterns in the binary pattern format, storing string items as ids
+ * of dictionary when one is given. with trie set the patterns are written as
+ * a prefix tree, which shares the most prefixes when patterns arrive in
+ * prefix_order but is correct in any order */
+template <typename T>
+class pattern_file_writer : public pattern_sink<T> {
+	public:
+		pattern_file_writer(const std::string &file_name, const item_dictionary<std::string> *dictionary=NULL, bool trie=false) : output(file_name), trie(trie), previous() {
+			std::string dictionary_bytes;
+			
+			pattern_file_header header;
+			std::memcpy(header.magic, pattern_file_magic, sizeof(pattern_file_magic));
+			header.version = pattern_file_version;
+			header.flags = binary_is_itemset(sequence<T>()) ? binary_itemset : 0;
+			if(trie) {
+				header.flags |= pattern_trie;
+			}
+			header.alphabet_size = 0;
+			
+			if(dictionary) {
+				std::vector<std::string> values(dictionary->begin(), dictionary->end());
+				header.flags |= binary_dictionary(values, dictionary_bytes);
+				header.alphabet_size = values.size();
+			}
+			header.dictionary_size = dictionary_bytes.size();
+			
+			static const char padding[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+			output.put(reinterpret_cast<const char *>(&header), sizeof(header));
+			output.put(dictionary_bytes);
+			output.put(padding, (8 - dictionary_bytes.size() % 8) % 8);
+		}
+		
+		virtual void write(const sequence<T> &seq, unsigned int support) {
+			if(trie) {
+				write_nodes(seq, support);
+				return;
+			}
+			
+			put((uint32_t) support);
+			put((uint32_t) seq.length());
+			
+			typename sequence<T>::const_iterator seq_iter = seq.begin();
+			for(; seq_iter != seq.end(); ++seq_iter) {
+				put_element(*seq_iter);
+			}
+		}
+		
+		virtual void close() {
+			output.close();
+		}
+		
+	private:
+		output_buffer output;
+		bool trie;
+		sequence<T> previous;
+		
+		/* writes the nodes of seq below its longest prefix shared with the
+		 * previous pattern, a pattern never shares all of its elements */
+		void write_nodes(const sequence<T> &seq, unsigned int support) {
+			std::size_t common = 0;
+			
+			typename sequence<T>::const_iterator seq_iter = seq.begin();
+			typename sequence<T>::const_iterator previous_iter = previous.begin();
+			for(; seq_iter != seq.end() && previous_iter != previous.end() && *seq_iter == *previous_iter; ++seq_iter, ++previous_iter) {
+				common++;
+			}
+			
+			if(common == seq.length() && common > 0) {
+				common--;
+			}
+			
+			std::size_t depth = 0;
+			for(seq_iter = seq.begin(); seq_iter != seq.end(); ++seq_iter) {
+				if(++depth > common) {
+					bool closed = (depth == seq.length());
+					
+					put((uint32_t) depth);
+					put((uint32_t) (closed ? support : 0));
+					put((uint32_t) (closed ? pattern_closed : 0));
+					put_element(*seq_iter);
+				}
+			}
+			
+			previous = seq;
+		}
+		
+		void put(uint32_t value) {
+			if(!trie) {
+				output.put(reinterpret_cast<const char *>(&value), sizeof(value));
+				return;
+			}
+			
+			while(value >= 0x80) {
+				output.put((char) ((value & 0x7f) | 0x80));
+				value >>= 7;
+			}
+			output.put((char) value);
+		}
+		
+		template <typename Value>
+		void put_element(const Value &item) {
+			put((uint32_t) item);
+		}
+		
+		template <typename Value>
+		void put_element(const ordered_set<Value> &set) {
+			put((uint32_t) set.size());
+			
+			typename ordered_set<Value>::const_iterator set_iter = set.begin();
+			for(; set_iter != set.end(); ++set_iter) {
+				put((uint32_t) *set_iter);
+			}
+		}
+};
+
+/* parses the text output of the miners, support lines each followed by the
+ * patterns with that support. a plain list of sequences is read with support 0 */
+template <typename Value>
+bool parse_patterns(const char *begin, const char *end, std::vector<std::pair<unsigned int,sequence<Value> > > &patterns) {
+	unsigned int support = 0;
+	
+	const char *line = begin;
+	while(line != end) {
+		const char *line_end = static_cast<const char *>(std::memchr(line, '\n', end - line));
+		if(line_end == NULL) {
+			line_end = end;
+		}
+		
+		const char *position = line;
+		while(position != line_end && (*position == ' ' || *position == '\t' || *position == '\r')) {
+			++position;
+		}
+		
+		if(position != line_end && *position == '<') {
+			patterns.push_back(std::pair<unsigned int,sequence<Value> >(support, sequence<Value>()));
+			
+			sequence_parser parser(position, line_end);
+			if(!parser.parse(patterns.back().second)) {
+				return false;
+			}
+			
+			sequence<Value> extra;
+			if(parser.parse(extra) || parser.fail()) {
+				return false;
+			}
+		}
+		else if(position != line_end) {
+			unsigned long value = 0;
+			for(; position != line_end && *position >= '0' && *position <= '9'; ++position) {
+				value = value * 10 + (*position - '0');
+				if(value > 0xffffffffUL) {
+					return false;
+				}
+			}
+			
+			while(position != line_end && (*position == ' ' || *position == '\t' || *position == '\r')) {
+				++position;
+			}
+			
+			if(position != line_end) {
+				return false;
+			}
+			
+			support = value;
+		}
+		
+		line = (line_end == end) ? end : line_end + 1;
+	}
+	
+	return true;
+}
+
+template <typename Value>
+bool read_pattern_file(const char *begin, const char *end, std::vector<std::pair<unsigned int,sequence<Value> > > &patterns) {
+	pattern_file file(begin, end);
+	
+	std::vector<typename binary_item<Value>::type> values;
+	if(!file.good() || file.itemset() != binary_is_itemset(sequence<Value>()) || !file.load_dictionary(values)) {
+		return false;
+	}
+	
+	unsigned int support;
+	sequence<Value> seq;
+	while(file.next(values, seq, support)) {
+		patterns.push_back(std::pair<unsigned int,sequence<Value> >(support, sequence<Value>()));
+		patterns.back().second.swap(seq);
+	}
+	
+	return !file.fail();
+}
+
+/* reads the patterns of a mining run with their supports, from either the
+ * binary pattern format or the text output of the miners */
+template <typename Value>
+void read_patterns(const std::string &file_name, std::vector<std::pair<unsigned int,sequence<Value> > > &patterns) {
+	mapped_file file(file_name);
+	
+	std::vector<std::pair<unsigned int,sequence<Value> > > tmp_patterns;
+	bool parsed;
+	if(is_pattern_file(file.begin(), file.end())) {
+		parsed = read_pattern_file(file.begin(), file.end(), tmp_patterns);
+	}
+	else {
+		parsed = parse_patterns(file.begin(), file.end(), tmp_patterns);
+	}
+	
+	if(!parsed) {
+		std::ostringstream oss;
+		oss <<  file_name << ": error reading file";
+		
+		throw std::runtime_error(oss.str());
+	}
+	
+	patterns.swap(tmp_patterns);
+}
+
+#endif
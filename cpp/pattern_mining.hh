@@ -17,8 +17,18 @@
 
 #include <cstring>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "ordered_set.hh"
 #include "sequence.hh"
+#include "sequence_parser.hh"
+#include "gzip_reader.hh"
+#include "item_dictionary.hh"
+#include "flat_database.hh"
+#include "pattern_sink.hh"
+#include "pattern_file.hh"
 
 #include "timer.hh"
 
@@ -29,24 +39,40 @@
 void usage(const char *file_name) {
 	std::cout << "Sequential Pattern Mining" << std::endl << std::endl;
 	
-	std::cout << "Usage:  " << file_name << " [-n/--numeric] [-i/--itemset] [-m/--min-support n] [-s/--strip-sequences] [--suffixfile file] [--rina]  [-o/--outfile file] infile" << std::endl;
+	std::cout << "Usage:  " << file_name << " [-n/--numeric] [-i/--itemset] [-m/--min-support n] [-s/--strip-sequences] [--suffixfile file] [--rina] [-c/--closed-only] [-l/--local-counting] [--cmap] [--index] [-t/--threads n] [-u/--unsorted] [-b/--binary] [--trie] [-o/--outfile file] infile" << std::endl;
 	std::cout << "  --itemset           treat items as sets " << std::endl;
 	std::cout << "  --numeric           sequence items are treated as nonnegative integers" << std::endl;
 	std::cout << "  --min-support       minimum support, number between 0.0 and 1.0, default 0.25" << std::endl;
 	std::cout << "  --strip-sequences   strip non-frequent items from database, default false" << std::endl;
 	std::cout << "  --suffixfile        file of suffixes for prefix-closed mining" << std::endl;
 	std::cout << "  --rina              " << std::endl;
+	std::cout << "  --closed-only       prune non-closed branches while mining (BIDE), default false" << std::endl;
+	std::cout << "  --local-counting    recount items in every projected database and extend only by locally frequent ones, default false" << std::endl;
+	std::cout << "  --cmap              skip extensions by item pairs that are not frequent 2-sequences, default false" << std::endl;
+	std::cout << "  --index             index item positions in every sequence and project by binary search, default false" << std::endl;
+	std::cout << "  --threads           number of threads used for mining, default 1" << std::endl;
+	std::cout << "  --unsorted          write patterns in the order they are found instead of sorted, default false" << std::endl;
+	std::cout << "  --binary            write patterns and their supports in the binary pattern format, default false" << std::endl;
+	std::cout << "  --trie              write patterns as a prefix tree in the binary pattern format instead of a flat list, default false" << std::endl;
 	std::cout << "  --outfile           write results to the specified file" << std::endl;
 	std::cout << "  infile              input sequence database" << std::endl;
 }
 
-bool parse_args(int argc, char *argv[], bool &numeric, bool &itemset, double &min_support, bool &strip_sequences, std::string &suffixfile, bool &rina, std::string &outfile, std::string &infile) {
+bool parse_args(int argc, char *argv[], bool &numeric, bool &itemset, double &min_support, bool &strip_sequences, std::string &suffixfile, bool &rina, bool &closed_only, bool &local_counting, bool &cmap, bool &index, unsigned int &threads, bool &unsorted, bool &binary, bool &trie, std::string &outfile, std::string &infile) {
 	numeric = false;
 	itemset = false;
 	min_support = 0.25;
 	strip_sequences = false;
 	suffixfile.clear();
 	rina = false;
+	closed_only = false;
+	local_counting = false;
+	cmap = false;
+	index = false;
+	threads = 1;
+	unsorted = false;
+	binary = false;
+	trie = false;
 	outfile.clear();
 	infile.clear();
 	
@@ -85,13 +111,13 @@ bool parse_args(int argc, char *argv[], bool &numeric, bool &itemset, double &mi
 					if(min_support == std::numeric_limits<double>::max()) {
 						std::cerr << "Minimum support specified exceeds maximum allowed value." << std::endl << std::endl;
 						usage(argv[0]);
-					
+						
 						return false;
 					}
 					else if(min_support == std::numeric_limits<double>::min()) {
 						std::cerr << "Minimum support specified less than minimum allowed value." << std::endl << std::endl;
 						usage(argv[0]);
-					
+						
 						return false;
 					}
 					else {
@@ -104,7 +130,7 @@ bool parse_args(int argc, char *argv[], bool &numeric, bool &itemset, double &mi
 				else if(min_support <= 0.0 || min_support > 1.0) {
 					std::cerr << "Minimum support must be a value between 0.0 and 1.0." << std::endl << std::endl;
 					usage(argv[0]);
-				
+					
 					return false;
 				}
 			}
@@ -125,6 +151,52 @@ bool parse_args(int argc, char *argv[], bool &numeric, bool &itemset, double &mi
 			else if(strcmp(argv[ii], "--rina") == 0) {
 				rina = true;
 			}
+			else if(strcmp(argv[ii], "-c") == 0 || strcmp(argv[ii], "--closed-only") == 0) {
+				closed_only = true;
+			}
+			else if(strcmp(argv[ii], "-l") == 0 || strcmp(argv[ii], "--local-counting") == 0) {
+				local_counting = true;
+			}
+			else if(strcmp(argv[ii], "--cmap") == 0) {
+				cmap = true;
+			}
+			else if(strcmp(argv[ii], "--index") == 0) {
+				index = true;
+			}
+			else if(strcmp(argv[ii], "-t") == 0 || strcmp(argv[ii], "--threads") == 0) {
+				ii++;
+				if(ii >= argc) {
+					std::cerr << "Option " << argv[ii-1] << " requires an argument." << std::endl << std::endl;
+					usage(argv[0]);
+					
+					return false;
+				}
+				
+				std::istringstream iss(argv[ii]);
+				iss >> threads;
+				
+				if(iss.bad() || iss.fail() || !iss.eof()) {
+					std::cerr << "Option " << argv[ii-1] << " requires an integer value." << std::endl << std::endl;
+					usage(argv[0]);
+					
+					return false;
+				}
+				else if(threads == 0) {
+					std::cerr << "Number of threads must be a positive integer." << std::endl << std::endl;
+					usage(argv[0]);
+					
+					return false;
+				}
+			}
+			else if(strcmp(argv[ii], "-u") == 0 || strcmp(argv[ii], "--unsorted") == 0) {
+				unsorted = true;
+			}
+			else if(strcmp(argv[ii], "-b") == 0 || strcmp(argv[ii], "--binary") == 0) {
+				binary = true;
+			}
+			else if(strcmp(argv[ii], "--trie") == 0) {
+				trie = true;
+			}
 			else if(strcmp(argv[ii], "-o") == 0 || strcmp(argv[ii], "--outfile") == 0) {
 				ii++;
 				if(ii >= argc) {
@@ -156,6 +228,13 @@ bool parse_args(int argc, char *argv[], bool &numeric, bool &itemset, double &mi
 			return false;
 		}
 		
+		if(binary && trie) {
+			std::cerr << "Options --binary and --trie are mutually exclusive." << std::endl << std::endl;
+			usage(argv[0]);
+			
+			return false;
+		}
+		
 		return true;
 	}
 }
@@ -164,41 +243,70 @@ template <typename Value>
 void read_database(const std::string &file_name, std::list<sequence<Value> > &database) {
 	timer<long double> time;
 	
-	std::ifstream file(file_name.c_str());
-	if(file) {
-		std::cout << "Read Time: ";
-		std::cout.flush();
-		
-		database.clear();
-		
-		time.tic();
-		file >> database;
-		std::cerr << time.toc() << ",";
-		std::cerr.flush();
-		
-		std::cout << std::endl;
-		
-		if(file.bad()) {
-			std::ostringstream oss;
-			oss <<  file_name << ": " << strerror(errno);
-			
-			throw std::runtime_error(oss.str());
-		}
-		else if(file.fail() && !file.eof()) {
-			std::ostringstream oss;
-			oss <<  file_name << ": error reading file";
-			
-			throw std::runtime_error(oss.str());
-		}
-	}
-	else {
+	std::cout << "Read Time: ";
+	std::cout.flush();
+	
+	database.clear();
+	
+	time.tic();
+	bool parsed = parse_database_file(file_name, database, true);
+	std::cerr << time.toc() << ",";
+	std::cerr.flush();
+	
+	std::cout << std::endl;
+	
+	if(!parsed) {
 		std::ostringstream oss;
-		oss <<  file_name << ": " << strerror(errno);
+		oss <<  file_name << ": error reading file";
 		
 		throw std::runtime_error(oss.str());
 	}
 }
 
+/* encode the string database, releasing each string sequence once it has been encoded */
+template <typename Value1, typename Value2>
+void intern_database(const item_dictionary<std::string> &dictionary, std::list<sequence<Value1> > &string_database, std::list<sequence<Value2> > &database) {
+	database.clear();
+	
+	while(!string_database.empty()) {
+		database.push_back(sequence<Value2>());
+		dictionary.encode(string_database.front(), database.back());
+		
+		string_database.pop_front();
+	}
+}
+
+/* read a database of string items, encoding it and any suffixes with a shared dictionary */
+template <typename Value>
+void read_database(const std::string &file_name, const std::string &suffix_file_name, item_dictionary<std::string> &dictionary, std::list<sequence<Value> > &database, std::list<sequence<Value> > &suffixes) {
+	typedef typename decoded_value<std::string,Value>::type string_value;
+	
+	timer<long double> time;
+	
+	std::list<sequence<string_value> > string_database;
+	read_database(file_name, string_database);
+	
+	std::list<sequence<string_value> > string_suffixes;
+	if(!suffix_file_name.empty()) {
+		read_database(suffix_file_name, string_suffixes);
+	}
+	
+	std::cout << "Intern Items: ";
+	std::cout.flush();
+	
+	time.tic();
+	dictionary.clear();
+	dictionary.insert(string_database);
+	dictionary.insert(string_suffixes);
+	
+	intern_database(dictionary, string_database, database);
+	intern_database(dictionary, string_suffixes, suffixes);
+	std::cerr << time.toc() << ",";
+	std::cerr.flush();
+	
+	std::cout << std::endl;
+}
+
 template <typename T>
 std::ostream & operator<<(std::ostream &output, const std::map<unsigned int,std::list<sequence<T> > > &patterns) {
 	typename std::map<unsigned int,std::list<sequence<T> > >::const_iterator patterns_iter = patterns.begin();
@@ -218,6 +326,18 @@ std::ostream & operator<<(std::ostream &output, const std::map<unsigned int,std:
 	return output;
 }
 
+/* hands the patterns to sink grouped by increasing support */
+template <typename T>
+void write_patterns(const std::map<unsigned int,std::list<sequence<T> > > &patterns, pattern_sink<T> &sink) {
+	typename std::map<unsigned int,std::list<sequence<T> > >::const_iterator patterns_iter = patterns.begin();
+	for(; patterns_iter != patterns.end(); ++patterns_iter) {
+		typename std::list<sequence<T> >::const_iterator sequences_iter = patterns_iter->second.begin();
+		for(; sequences_iter != patterns_iter->second.end(); ++sequences_iter) {
+			sink.write(*sequences_iter, patterns_iter->first);
+		}
+	}
+}
+
 /*template <typename T>
 std::ostream & operator<<(std::ostream &output, const std::map<unsigned int,std::set<sequence<T> > > &patterns) {
 	typename std::map<unsigned int,std::set<sequence<T> > >::const_iterator patterns_iter = patterns.begin();
@@ -236,75 +356,46 @@ std::ostream & operator<<(std::ostream &output, const std::map<unsigned int,std:
 	return output;
 }*/
 
-template <template <typename, typename> class Miner, typename Value1, typename Value2>
-void mine(std::list<sequence<Value1> > &database, const std::string &outfile, double min_support, bool strip_sequences, const Miner<Value1,Value2> &miner) {
-	std::map<unsigned int,std::list<sequence<Value1> > > patterns;
+/* moves the database into contiguous storage, releasing each sequence once copied */
+template <typename Value>
+void flatten_database(std::list<sequence<Value> > &database, flat_database<Value> &flat) {
+	timer<long double> time;
 	
-	miner.mine(database, min_support, strip_sequences, patterns);
+	std::cout << "Flatten Database: ";
+	std::cout.flush();
 	
-	if(!outfile.empty()) {
-		std::ofstream output(outfile.c_str());
-		if(output) {
-			output << patterns << std::endl;
-			if(output.bad()) {
-				std::ostringstream oss;
-				oss <<  outfile << ": " << strerror(errno);
-				
-				throw std::runtime_error(oss.str());
-			}
-		}
-		else {
-			std::ostringstream oss;
-			oss <<  outfile << ": " << strerror(errno);
-			
-			throw std::runtime_error(oss.str());
-		}
+	time.tic();
+	
+	flat.clear();
+	while(!database.empty()) {
+		flat.push_back(database.front());
+		database.pop_front();
 	}
 	
-	#ifndef NDEBUG
-		std::string output_graph_name(database_file);
-		output_graph_name += ".gv";
-		
-		std::ofstream output_graph_file(output_graph_name.c_str());
-		if(output_graph_file) {
-			std::vector<std::vector<std::string> > &graph = miner.graph;
-			
-			output_graph_file << "digraph G {" << std::endl;
-			
-			std::vector<std::vector<std::string> >::iterator graph_iter = graph.begin();
-			for(; graph_iter != graph.end(); ++graph_iter) {
-				output_graph_file << "\t\"" << graph_iter->at(0) << "\" -> \"" << graph_iter->at(2) << "\" [label=\"" << graph_iter->at(1) << "\"]" << std::endl;
-			}
-			output_graph_file << "}" << std::endl;
-			
-			if(output_graph_file.bad()) {
-				std::ostringstream oss;
-				oss <<  output_graph_name << ": " << strerror(errno);
-				
-				throw std::runtime_error(oss.str());
-			}
-		}
-		else {
-			std::ostringstream oss;
-			oss <<  output_graph_name << ": " << strerror(errno);
-			
-			throw std::runtime_error(oss.str());
-		}
-	#endif
+	std::cerr << time.toc() << ",";
+	std::cerr.flush();
+	
+	std::cout << std::endl;
+}
+
+template <template <typename, typename> class Miner, typename Value1, typename Value2, typename Patterns>
+void mine(std::list<sequence<Value1> > &database, double min_support, bool strip_sequences, const Miner<Value1,Value2> &miner, Patterns &patterns) {
+	flat_database<Value1> flat;
+	flatten_database(database, flat);
+	
+	miner.mine(flat, min_support, strip_sequences, patterns);
 }
 
 template <template <typename, typename> class Miner, typename Value1, typename Value2>
-void mine_prefixes(std::list<sequence<Value1> > &database, std::list<sequence<Value1> > &suffixes, const std::string &outfile, double min_support, bool strip_sequences, const Miner<Value1,Value2> &miner) {
+void mine_prefixes(std::list<sequence<Value1> > &database, std::list<sequence<Value1> > &suffixes, double min_support, bool strip_sequences, const Miner<Value1,Value2> &miner, std::map<unsigned int,std::list<sequence<Value1> > > &prefix_patterns) {
 	std::map<unsigned int,std::list<sequence<Value1> > > patterns;
 	
 	miner.mine(database, min_support, strip_sequences, patterns);
 	
-	std::map<unsigned int,std::list<sequence<Value1> > > prefix_patterns;
-	
 	sequence<Value1> tmp_seq;
 	typename std::list<sequence<Value1> >::iterator suffixes_iter = suffixes.begin();
 	for(; suffixes_iter != suffixes.end(); ++suffixes_iter) {
-	
+		
 		typename std::map<unsigned int,std::list<sequence<Value1> > >::reverse_iterator patterns_iter = patterns.rbegin();
 		for(; patterns_iter != patterns.rend(); ++patterns_iter) {
 			std::list<sequence<Value1> > &sequences = patterns_iter->second;
@@ -351,25 +442,6 @@ void mine_prefixes(std::list<sequence<Value1> > &database, std::list<sequence<Va
 		}
 	}
 	
-	if(!outfile.empty()) {
-		std::ofstream output(outfile.c_str());
-		if(output) {
-			output << prefix_patterns << std::endl;
-			if(output.bad()) {
-				std::ostringstream oss;
-				oss <<  outfile << ": " << strerror(errno);
-				
-				throw std::runtime_error(oss.str());
-			}
-		}
-		else {
-			std::ostringstream oss;
-			oss <<  outfile << ": " << strerror(errno);
-			
-			throw std::runtime_error(oss.str());
-		}
-	}
-	
 	/*result.clear();
 	
 	if(suffix.rbegin()->subset(*pattern.rbegin())) {
@@ -381,11 +453,9 @@ void mine_prefixes(std::list<sequence<Value1> > &database, std::list<sequence<Va
 }
 
 template <template <typename, typename> class Miner, typename Value1, typename Value2>
-void rina_mine_prefixes(std::list<sequence<Value1> > &database, std::list<sequence<Value1> > &suffixes, const std::string &outfile, double min_support, bool strip_sequences, const Miner<Value1,Value2> &miner) {
+void rina_mine_prefixes(std::list<sequence<Value1> > &database, std::list<sequence<Value1> > &suffixes, double min_support, bool strip_sequences, const Miner<Value1,Value2> &miner, std::map<unsigned int,std::list<sequence<Value1> > > &prefix_patterns) {
 	std::list<sequence<Value1> > suffix_projected_database(database.size());
 	
-	std::map<unsigned int,std::list<sequence<Value1> > > prefix_patterns;
-	
 	typename std::list<sequence<Value1> >::iterator suffixes_iter = suffixes.begin();
 	for(; suffixes_iter != suffixes.end(); ++suffixes_iter) {
 		
@@ -414,29 +484,45 @@ void rina_mine_prefixes(std::list<sequence<Value1> > &database, std::list<sequen
 			}
 		}
 	}
-	
-	if(!outfile.empty()) {
-		std::ofstream output(outfile.c_str());
-		if(output) {
-			output << prefix_patterns << std::endl;
-			if(output.bad()) {
-				std::ostringstream oss;
-				oss <<  outfile << ": " << strerror(errno);
-				
-				throw std::runtime_error(oss.str());
-			}
+}
+
+/* mines database, or its prefixes when suffixes are given, handing the patterns to sink */
+template <template <typename, typename> class Miner, typename Value1, typename Value2>
+void mine(std::list<sequence<Value1> > &database, std::list<sequence<Value1> > &suffixes, bool rina, double min_support, bool strip_sequences, const Miner<Value1,Value2> &miner, pattern_sink<Value1> &sink) {
+	if(suffixes.empty()) {
+		/* patterns go straight from the miner to the sink */
+		mine(database, min_support, strip_sequences, miner, sink);
+	}
+	else {
+		std::map<unsigned int,std::list<sequence<Value1> > > patterns;
+		if(rina) {
+			rina_mine_prefixes(database, suffixes, min_support, strip_sequences, miner, patterns);
 		}
 		else {
-			std::ostringstream oss;
-			oss <<  outfile << ": " << strerror(errno);
-			
-			throw std::runtime_error(oss.str());
+			mine_prefixes(database, suffixes, min_support, strip_sequences, miner, patterns);
 		}
+		
+		write_patterns(patterns, sink);
+	}
+}
+
+/* mines into writer, through a sort in the order of Compare unless unsorted */
+template <template <typename, typename> class Miner, typename Value1, typename Value2, typename Compare>
+void mine(std::list<sequence<Value1> > &database, std::list<sequence<Value1> > &suffixes, bool rina, double min_support, bool strip_sequences, bool unsorted, const Compare &, const Miner<Value1,Value2> &miner, pattern_sink<Value1> &writer) {
+	if(unsorted) {
+		mine(database, suffixes, rina, min_support, strip_sequences, miner, writer);
+	}
+	else {
+		external_sort<Value1,Compare> sorter(writer);
+		mine(database, suffixes, rina, min_support, strip_sequences, miner, sorter);
+		sorter.close();
 	}
+	
+	writer.close();
 }
 
 template <template <typename, typename> class Miner, typename Value1, typename Value2>
-void mine(const std::string &database_file, const std::string &suffix_file, bool rina, const std::string &outfile, double min_support, bool strip_sequences, const Miner<Value1,Value2> &miner) {
+void mine(const std::string &database_file, const std::string &suffix_file, bool rina, bool numeric, bool unsorted, bool binary, bool trie, const std::string &outfile, double min_support, bool strip_sequences, const Miner<Value1,Value2> &miner) {
 	std::cout << "Min Support: ";
 	std::cout.flush();
 	std::cerr << min_support << ",";
@@ -444,37 +530,92 @@ void mine(const std::string &database_file, const std::string &suffix_file, bool
 	std::cout << std::endl;
 	
 	std::list<sequence<Value1> > database;
-	read_database(database_file, database);
+	std::list<sequence<Value1> > suffixes;
+	item_dictionary<std::string> dictionary;
+	if(numeric) {
+		read_database(database_file, database);
+		if(!suffix_file.empty()) {
+			read_database(suffix_file, suffixes);
+		}
+	}
+	else {
+		read_database(database_file, suffix_file, dictionary, database, suffixes);
+	}
 	
-	if(suffix_file.empty()) {
-		mine(database, outfile, min_support, strip_sequences, miner);	
+	if(!suffix_file.empty() && suffixes.empty()) {
+		std::ostringstream oss;
+		oss <<  suffix_file << ": no suffixes found";
+		
+		throw std::runtime_error(oss.str());
+	}
+	
+	const item_dictionary<std::string> *decoder = numeric ? NULL : &dictionary;
+	if(outfile.empty()) {
+		null_pattern_sink<Value1> sink;
+		mine(database, suffixes, rina, min_support, strip_sequences, miner, sink);
+	}
+	else if(trie) {
+		pattern_file_writer<Value1> writer(outfile, decoder, true);
+		mine(database, suffixes, rina, min_support, strip_sequences, unsorted, prefix_order<Value1>(), miner, writer);
+	}
+	else if(binary) {
+		pattern_file_writer<Value1> writer(outfile, decoder);
+		mine(database, suffixes, rina, min_support, strip_sequences, unsorted, support_order<Value1>(), miner, writer);
 	}
 	else {
-		std::list<sequence<Value1> > suffixes;
-		read_database(suffix_file, suffixes);
+		pattern_writer<Value1> writer(outfile, decoder);
+		mine(database, suffixes, rina, min_support, strip_sequences, unsorted, support_order<Value1>(), miner, writer);
+	}
+	
+	#ifndef NDEBUG
+		std::string output_graph_name(database_file);
+		output_graph_name += ".gv";
 		
-		if(suffixes.empty()) {
-			std::ostringstream oss;
-			oss <<  suffix_file << ": no suffixes found";
+		std::ofstream output_graph_file(output_graph_name.c_str());
+		if(output_graph_file) {
+			std::vector<std::vector<std::string> > &graph = miner.graph;
 			
-			throw std::runtime_error(oss.str());
-		}
-		
-		if(rina) {
-			rina_mine_prefixes(database, suffixes, outfile, min_support, strip_sequences, miner);
+			output_graph_file << "digraph G {" << std::endl;
+			
+			std::vector<std::vector<std::string> >::iterator graph_iter = graph.begin();
+			for(; graph_iter != graph.end(); ++graph_iter) {
+				output_graph_file << "\t\"" << graph_iter->at(0) << "\" -> \"" << graph_iter->at(2) << "\" [label=\"" << graph_iter->at(1) << "\"]" << std::endl;
+			}
+			output_graph_file << "}" << std::endl;
+			
+			if(output_graph_file.bad()) {
+				std::ostringstream oss;
+				oss <<  output_graph_name << ": " << strerror(errno);
+				
+				throw std::runtime_error(oss.str());
+			}
 		}
 		else {
-			mine_prefixes(database, suffixes, outfile, min_support, strip_sequences, miner);
+			std::ostringstream oss;
+			oss <<  output_graph_name << ": " << strerror(errno);
+			
+			throw std::runtime_error(oss.str());
 		}
-	}
-	
+	#endif
 }
 
 template <template <typename, typename> class Miner, typename Value1, typename Value2>
-void run(double min_support, bool strip_sequences, const std::string &infile, const std::string &suffixfile, bool rina, const std::string &outfile, const Miner<Value1,Value2> &miner) {
+void run(double min_support, bool strip_sequences, bool numeric, const std::string &infile, const std::string &suffixfile, bool rina, unsigned int threads, bool unsorted, bool binary, bool trie, const std::string &outfile, const Miner<Value1,Value2> &miner) {
 	timer<long double> time;			
-			
-	mine(infile, suffixfile, rina, outfile, min_support, strip_sequences, miner);
+	
+	#ifdef _OPENMP
+	if(threads > 1 && !miner.supports_threads()) {
+		std::cerr << "warning: miner does not spawn tasks, only reading the database uses " << threads << " threads, mining uses one" << std::endl;
+	}
+	
+	omp_set_num_threads(threads);
+	#else
+	if(threads > 1) {
+		std::cerr << "warning: compiled without OpenMP, mining with a single thread" << std::endl;
+	}
+	#endif
+	
+	mine(infile, suffixfile, rina, numeric, unsorted, binary, trie, outfile, min_support, strip_sequences, miner);
 	//prefix_closed_mining_rina(infile, std::string("suffixes.dat"), min_support, strip_sequences, miner);
 	
 	std::cout << "Total: ";
@@ -489,24 +630,35 @@ int run(int argc, char *argv[]) {
 	double min_support;
 	bool strip_sequences;
 	bool rina;
+	bool closed_only;
+	bool local_counting;
+	bool cmap;
+	bool index;
+	unsigned int threads;
+	bool unsorted;
+	bool binary;
+	bool trie;
 	std::string output_name, suffix_name, database_name;
-	if(parse_args(argc, argv, numeric, itemset, min_support, strip_sequences, suffix_name, rina, output_name, database_name)) {
+	if(parse_args(argc, argv, numeric, itemset, min_support, strip_sequences, suffix_name, rina, closed_only, local_counting, cmap, index, threads, unsorted, binary, trie, output_name, database_name)) {
 		try {
+			// string items are interned to dense ids, so both cases mine integers
 			if(itemset) {
-				if(numeric) {
-					run(min_support, strip_sequences, database_name, suffix_name, rina, output_name, Miner<ordered_set<int>,int>());
-				}
-				else {
-					run(min_support, strip_sequences, database_name, suffix_name, rina, output_name, Miner<ordered_set<std::string>,std::string>());
-				}
+				Miner<ordered_set<int>,int> miner;
+				miner.set_closed_only(closed_only);
+				miner.set_local_counting(local_counting);
+				miner.set_cooccurrence_pruning(cmap);
+				miner.set_position_indexing(index);
+				
+				run(min_support, strip_sequences, numeric, database_name, suffix_name, rina, threads, unsorted, binary, trie, output_name, miner);
 			}
 			else {
-				if(numeric) {
-					run(min_support, strip_sequences, database_name, suffix_name, rina, output_name, Miner<int,int>());
-				}
-				else {
-					run(min_support, strip_sequences, database_name, suffix_name, rina, output_name, Miner<std::string,std::string>());
-				}
+				Miner<int,int> miner;
+				miner.set_closed_only(closed_only);
+				miner.set_local_counting(local_counting);
+				miner.set_cooccurrence_pruning(cmap);
+				miner.set_position_indexing(index);
+				
+				run(min_support, strip_sequences, numeric, database_name, suffix_name, rina, threads, unsorted, binary, trie, output_name, miner);
 			}
 		}
 		catch(std::exception &e) {
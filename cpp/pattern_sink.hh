@@ -0,0 +1,414 @@
+#ifndef _PATTERN_SINK_HH_
+#define _PATTERN_SINK_HH_
+
+#include <sstream>
+
+#include <list>
+#include <map>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <algorithm>
+
+#include <stdexcept>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+
+#include "ordered_set.hh"
+#include "sequence.hh"
+#include "item_dictionary.hh"
+#include "output_buffer.hh"
+
+/* receives mined patterns one at a time, with their support
+ *
+ * miners hand over their patterns grouped by increasing support, so a sink
+ * can write them out as they arrive instead of collecting them first. closed-
+ * only searches hand them over in the order they are found instead. */
+template <typename T>
+class pattern_sink {
+	public:
+		virtual ~pattern_sink() {
+			
+		}
+		
+		virtual void write(const sequence<T> &seq, unsigned int support) = 0;
+		
+		/* called once after the last pattern */
+		virtual void close() {
+			
+		}
+};
+
+/* drops every pattern, for runs without an output file */
+template <typename T>
+class null_pattern_sink : public pattern_sink<T> {
+	public:
+		virtual void write(const sequence<T> &, unsigned int) {
+			
+		}
+};
+
+/* collects the patterns of each support in a map, for callers that post-process them */
+template <typename T>
+class pattern_map_sink : public pattern_sink<T> {
+	public:
+		explicit pattern_map_sink(std::map<unsigned int,std::list<sequence<T> > > &patterns) : patterns(patterns) {
+			
+		}
+		
+		virtual void write(const sequence<T> &seq, unsigned int support) {
+			patterns[support].push_back(seq);
+		}
+		
+	private:
+		std::map<unsigned int,std::list<sequence<T> > > &patterns;
+};
+
+/* writes patterns in the text format, a support line followed by the patterns
+ * with that support, decoding string items through dictionary when given */
+template <typename T>
+class pattern_writer : public pattern_sink<T> {
+	public:
+		pattern_writer(const std::string &file_name, const item_dictionary<std::string> *dictionary=NULL) : output(file_name), dictionary(dictionary), support(0), empty(true) {
+			
+		}
+		
+		virtual void write(const sequence<T> &seq, unsigned int seq_support) {
+			if(empty || seq_support != support) {
+				output.put(seq_support);
+				output.put('\n');
+				
+				support = seq_support;
+				empty = false;
+			}
+			
+			put_sequence(seq);
+			output.put('\n');
+		}
+		
+		virtual void close() {
+			output.put('\n');
+			output.close();
+		}
+		
+	private:
+		output_buffer output;
+		const item_dictionary<std::string> *dictionary;
+		unsigned int support;
+		bool empty;
+		
+		template <typename Value>
+		void put_item(const Value &item) {
+			if(dictionary) {
+				output.put(dictionary->decode(item));
+			}
+			else {
+				output.put(item);
+			}
+		}
+		
+		template <typename Value>
+		void put_element(const Value &item) {
+			put_item(item);
+		}
+		
+		template <typename Value>
+		void put_element(const ordered_set<Value> &set) {
+			output.put('(');
+			
+			typename ordered_set<Value>::const_iterator set_iter = set.begin();
+			for(; set_iter != set.end(); ++set_iter) {
+				if(set_iter != set.begin()) {
+					output.put(',');
+				}
+				put_item(*set_iter);
+			}
+			
+			output.put(')');
+		}
+		
+		void put_sequence(const sequence<T> &seq) {
+			output.put('<');
+			
+			typename sequence<T>::const_iterator seq_iter = seq.begin();
+			for(; seq_iter != seq.end(); ++seq_iter) {
+				if(seq_iter != seq.begin()) {
+					output.put(',');
+				}
+				put_element(*seq_iter);
+			}
+			
+			output.put('>');
+		}
+};
+
+/* temporary file holding one sorted run of patterns for external_sort */
+template <typename T>
+class pattern_run {
+	public:
+		pattern_run() : file(std::tmpfile()), head() {
+			if(file == NULL) {
+				throw_error();
+			}
+		}
+		
+		~pattern_run() {
+			std::fclose(file);
+		}
+		
+		void write(const std::pair<unsigned int,sequence<T> > &pattern) {
+			put((uint32_t) pattern.first);
+			put((uint32_t) pattern.second.length());
+			
+			typename sequence<T>::const_iterator seq_iter = pattern.second.begin();
+			for(; seq_iter != pattern.second.end(); ++seq_iter) {
+				put_element(*seq_iter);
+			}
+		}
+		
+		/* rewinds the run for reading and loads its first pattern */
+		bool start() {
+			if(std::fflush(file) != 0 || std::ferror(file)) {
+				throw_error();
+			}
+			std::rewind(file);
+			
+			return next();
+		}
+		
+		/* loads the next pattern into head, false at the end of the run */
+		bool next() {
+			uint32_t support, length;
+			if(!get(support)) {
+				return false;
+			}
+			
+			head.first = support;
+			head.second.clear();
+			if(!get(length)) {
+				throw_read_error();
+			}
+			
+			for(uint32_t ii=0; ii < length; ii++) {
+				get_element(head.second);
+			}
+			
+			return true;
+		}
+		
+		const std::pair<unsigned int,sequence<T> > & front() const {
+			return head;
+		}
+		
+	private:
+		std::FILE *file;
+		std::pair<unsigned int,sequence<T> > head;
+		
+		pattern_run(const pattern_run &);
+		pattern_run & operator=(const pattern_run &);
+		
+		void put(uint32_t value) {
+			if(std::fwrite(&value, sizeof(value), 1, file) != 1) {
+				throw_error();
+			}
+		}
+		
+		void put(int32_t value) {
+			if(std::fwrite(&value, sizeof(value), 1, file) != 1) {
+				throw_error();
+			}
+		}
+		
+		bool get(uint32_t &value) {
+			return std::fread(&value, sizeof(value), 1, file) == 1;
+		}
+		
+		bool get(int32_t &value) {
+			return std::fread(&value, sizeof(value), 1, file) == 1;
+		}
+		
+		template <typename Value>
+		void put_element(const Value &item) {
+			put((int32_t) item);
+		}
+		
+		template <typename Value>
+		void put_element(const ordered_set<Value> &set) {
+			put((uint32_t) set.size());
+			
+			typename ordered_set<Value>::const_iterator set_iter = set.begin();
+			for(; set_iter != set.end(); ++set_iter) {
+				put((int32_t) *set_iter);
+			}
+		}
+		
+		template <typename Value>
+		void get_element(sequence<Value> &seq) {
+			int32_t item;
+			if(!get(item)) {
+				throw_read_error();
+			}
+			
+			seq.push_element((Value) item);
+		}
+		
+		template <typename Value>
+		void get_element(sequence<ordered_set<Value> > &seq) {
+			uint32_t size;
+			if(!get(size)) {
+				throw_read_error();
+			}
+			
+			seq.push_element(ordered_set<Value>());
+			for(uint32_t ii=0; ii < size; ii++) {
+				int32_t item;
+				if(!get(item)) {
+					throw_read_error();
+				}
+				
+				seq.push_item((Value) item);
+			}
+		}
+		
+		static void throw_error() {
+			std::ostringstream oss;
+			oss << "pattern sort: " << strerror(errno);
+			
+			throw std::runtime_error(oss.str());
+		}
+		
+		static void throw_read_error() {
+			throw std::runtime_error("pattern sort: error reading temporary file");
+		}
+};
+
+/* order of the text output, by support and then by sequence */
+template <typename T>
+struct support_order {
+	bool operator()(const std::pair<unsigned int,sequence<T> > &lhs, const std::pair<unsigned int,sequence<T> > &rhs) const {
+		return lhs < rhs;
+	}
+};
+
+/* element by element, so patterns sharing a prefix are next to each other and
+ * every prefix comes before its extensions */
+template <typename T>
+struct prefix_order {
+	bool operator()(const std::pair<unsigned int,sequence<T> > &lhs, const std::pair<unsigned int,sequence<T> > &rhs) const {
+		if(std::lexicographical_compare(lhs.second.begin(), lhs.second.end(), rhs.second.begin(), rhs.second.end())) {
+			return true;
+		}
+		else if(std::lexicographical_compare(rhs.second.begin(), rhs.second.end(), lhs.second.begin(), lhs.second.end())) {
+			return false;
+		}
+		
+		return lhs.first < rhs.first;
+	}
+};
+
+/* passes patterns on in the order given by Compare, by default by support and
+ * then by sequence, the order of the sorted output. holds at most run_size
+ * patterns in memory, larger outputs are sorted in runs spilled to temporary
+ * files and merged on close */
+template <typename T, typename Compare=support_order<T> >
+class external_sort : public pattern_sink<T> {
+	public:
+		external_sort(pattern_sink<T> &output, std::size_t run_size=1 << 20) : output(output), run_size(run_size), compare(), patterns(), runs() {
+			
+		}
+		
+		~external_sort() {
+			typename std::vector<pattern_run<T> *>::iterator runs_iter = runs.begin();
+			for(; runs_iter != runs.end(); ++runs_iter) {
+				delete *runs_iter;
+			}
+		}
+		
+		virtual void write(const sequence<T> &seq, unsigned int support) {
+			patterns.push_back(std::pair<unsigned int,sequence<T> >(support, seq));
+			if(patterns.size() >= run_size) {
+				spill();
+			}
+		}
+		
+		virtual void close() {
+			if(runs.empty()) {
+				std::sort(patterns.begin(), patterns.end(), compare);
+				
+				typename std::vector<std::pair<unsigned int,sequence<T> > >::const_iterator patterns_iter = patterns.begin();
+				for(; patterns_iter != patterns.end(); ++patterns_iter) {
+					output.write(patterns_iter->second, patterns_iter->first);
+				}
+				
+				patterns.clear();
+				return;
+			}
+			
+			if(!patterns.empty()) {
+				spill();
+			}
+			
+			later_run order(compare);
+			std::priority_queue<pattern_run<T> *, std::vector<pattern_run<T> *>, later_run> heads(order);
+			
+			typename std::vector<pattern_run<T> *>::iterator runs_iter = runs.begin();
+			for(; runs_iter != runs.end(); ++runs_iter) {
+				if((*runs_iter)->start()) {
+					heads.push(*runs_iter);
+				}
+			}
+			
+			while(!heads.empty()) {
+				pattern_run<T> *run = heads.top();
+				heads.pop();
+				
+				output.write(run->front().second, run->front().first);
+				if(run->next()) {
+					heads.push(run);
+				}
+			}
+		}
+		
+	private:
+		pattern_sink<T> &output;
+		std::size_t run_size;
+		Compare compare;
+		std::vector<std::pair<unsigned int,sequence<T> > > patterns;
+		std::vector<pattern_run<T> *> runs;
+		
+		external_sort(const external_sort &);
+		external_sort & operator=(const external_sort &);
+		
+		struct later_run {
+			Compare compare;
+			
+			later_run(const Compare &compare) : compare(compare) {
+				
+			}
+			
+			bool operator()(const pattern_run<T> *lhs, const pattern_run<T> *rhs) const {
+				return compare(rhs->front(), lhs->front());
+			}
+		};
+		
+		void spill() {
+			std::sort(patterns.begin(), patterns.end(), compare);
+			
+			runs.push_back(NULL);
+			runs.back() = new pattern_run<T>();
+			
+			typename std::vector<std::pair<unsigned int,sequence<T> > >::const_iterator patterns_iter = patterns.begin();
+			for(; patterns_iter != patterns.end(); ++patterns_iter) {
+				runs.back()->write(*patterns_iter);
+			}
+			
+			std::vector<std::pair<unsigned int,sequence<T> > >().swap(patterns);
+		}
+};
+
+#endif
@@ -0,0 +1,150 @@
+#ifndef _POSITION_INDEX_HH_
+#define _POSITION_INDEX_HH_
+
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include <algorithm>
+
+#include "ordered_set.hh"
+
+/* where every item of a sequence occurs
+ *
+ * the sorted positions of each item, so the next occurrence of an item after a
+ * position is found by binary search instead of scanning the sequence. */
+template <typename T>
+class position_index {
+	public:
+		static const unsigned int npos = ~0u;
+		
+		position_index() : items(), offsets(1, 0), positions(), length(0) {
+			
+		}
+		
+		template <typename Sequence>
+		explicit position_index(const Sequence &seq) : items(), offsets(1, 0), positions(), length(0) {
+			std::vector<std::pair<T,unsigned int> > occurrences;
+			
+			typename Sequence::const_iterator seq_iter = seq.begin();
+			for(; seq_iter != seq.end(); ++seq_iter, length++) {
+				occurrences.push_back(std::pair<T,unsigned int>(*seq_iter, length));
+			}
+			
+			build(occurrences);
+		}
+		
+		/* number of positions in the sequence */
+		unsigned int size() const {
+			return length;
+		}
+		
+		/* first position at or after position holding item, npos if there is none */
+		unsigned int next(const T &item, unsigned int position) const {
+			typename std::vector<T>::const_iterator items_iter = std::lower_bound(items.begin(), items.end(), item);
+			if(items_iter == items.end() || item < *items_iter) {
+				return npos;
+			}
+			
+			std::size_t item_index = items_iter - items.begin();
+			std::vector<unsigned int>::const_iterator positions_end = positions.begin() + offsets[item_index+1];
+			std::vector<unsigned int>::const_iterator positions_iter = std::lower_bound(positions.begin() + offsets[item_index], positions_end, position);
+			
+			return positions_iter == positions_end ? npos : *positions_iter;
+		}
+		
+		void swap(position_index &other) {
+			items.swap(other.items);
+			offsets.swap(other.offsets);
+			positions.swap(other.positions);
+			std::swap(length, other.length);
+		}
+		
+	protected:
+		/* distinct items, sorted, with the positions of items[ii] in
+		 * positions[offsets[ii], offsets[ii+1]) */
+		std::vector<T> items;
+		std::vector<unsigned int> offsets;
+		std::vector<unsigned int> positions;
+		unsigned int length;
+		
+		void build(std::vector<std::pair<T,unsigned int> > &occurrences) {
+			std::sort(occurrences.begin(), occurrences.end());
+			
+			positions.reserve(occurrences.size());
+			typename std::vector<std::pair<T,unsigned int> >::const_iterator occurrences_iter = occurrences.begin();
+			for(; occurrences_iter != occurrences.end(); ++occurrences_iter) {
+				if(items.empty() || items.back() < occurrences_iter->first) {
+					if(!items.empty()) {
+						offsets.push_back(positions.size());
+					}
+					items.push_back(occurrences_iter->first);
+				}
+				
+				positions.push_back(occurrences_iter->second);
+			}
+			
+			if(!items.empty()) {
+				offsets.push_back(positions.size());
+			}
+		}
+};
+
+template <typename T>
+const unsigned int position_index<T>::npos;
+
+/* for sequences of itemsets the positions are those of the elements */
+template <typename T>
+class position_index<ordered_set<T> > : public position_index<T> {
+	public:
+		position_index() : position_index<T>() {
+			
+		}
+		
+		template <typename Sequence>
+		explicit position_index(const Sequence &seq) : position_index<T>() {
+			std::vector<std::pair<T,unsigned int> > occurrences;
+			
+			typename Sequence::const_iterator seq_iter = seq.begin();
+			for(; seq_iter != seq.end(); ++seq_iter, this->length++) {
+				typename std::iterator_traits<typename Sequence::const_iterator>::value_type::const_iterator set_iter = seq_iter->begin();
+				for(; set_iter != seq_iter->end(); ++set_iter) {
+					occurrences.push_back(std::pair<T,unsigned int>(*set_iter, this->length));
+				}
+			}
+			
+			this->build(occurrences);
+		}
+		
+		/* first element at or after position holding every item of set, npos if
+		 * there is none. jumps to the latest next occurrence of the items until
+		 * they all agree */
+		template <typename Set>
+		unsigned int next_element(const Set &set, unsigned int position) const {
+			if(position >= this->length) {
+				return position_index<T>::npos;
+			}
+			
+			bool agreed = false;
+			while(!agreed) {
+				agreed = true;
+				
+				typename Set::const_iterator set_iter = set.begin();
+				for(; set_iter != set.end(); ++set_iter) {
+					unsigned int item_position = this->next(*set_iter, position);
+					if(item_position == position_index<T>::npos) {
+						return position_index<T>::npos;
+					}
+					
+					if(item_position != position) {
+						position = item_position;
+						agreed = false;
+					}
+				}
+			}
+			
+			return position;
+		}
+};
+
+#endif
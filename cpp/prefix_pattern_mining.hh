@@ -19,6 +19,8 @@
 
 #include "ordered_set.hh"
 #include "sequence.hh"
+#include "sequence_parser.hh"
+#include "gzip_reader.hh"
 
 #include "timer.hh"
 
@@ -83,13 +85,13 @@ bool parse_args(int argc, char *argv[], bool &numeric, bool &itemset, double &mi
 					if(min_support == std::numeric_limits<double>::max()) {
 						std::cerr << "Minimum support specified exceeds maximum allowed value." << std::endl << std::endl;
 						usage(argv[0]);
-					
+						
 						return false;
 					}
 					else if(min_support == std::numeric_limits<double>::min()) {
 						std::cerr << "Minimum support specified less than minimum allowed value." << std::endl << std::endl;
 						usage(argv[0]);
-					
+						
 						return false;
 					}
 					else {
@@ -102,7 +104,7 @@ bool parse_args(int argc, char *argv[], bool &numeric, bool &itemset, double &mi
 				else if(min_support <= 0.0 || min_support > 1.0) {
 					std::cerr << "Minimum support must be a value between 0.0 and 1.0." << std::endl << std::endl;
 					usage(argv[0]);
-				
+					
 					return false;
 				}
 			}
@@ -159,36 +161,21 @@ template <typename Value>
 void read_database(const std::string &file_name, std::list<sequence<Value> > &database) {
 	timer<long double> time;
 	
-	std::ifstream file(file_name.c_str());
-	if(file) {
-		std::cout << "Read Time: ";
-		std::cout.flush();
-		
-		database.clear();
-		
-		time.tic();
-		file >> database;
-		std::cerr << time.toc() << ",";
-		std::cerr.flush();
-		
-		std::cout << std::endl;
-		
-		if(file.bad()) {
-			std::ostringstream oss;
-			oss <<  file_name << ": " << strerror(errno);
-			
-			throw std::runtime_error(oss.str());
-		}
-		else if(file.fail() && !file.eof()) {
-			std::ostringstream oss;
-			oss <<  file_name << ": error reading file";
-			
-			throw std::runtime_error(oss.str());
-		}
-	}
-	else {
+	std::cout << "Read Time: ";
+	std::cout.flush();
+	
+	database.clear();
+	
+	time.tic();
+	bool parsed = parse_database_file(file_name, database, true);
+	std::cerr << time.toc() << ",";
+	std::cerr.flush();
+	
+	std::cout << std::endl;
+	
+	if(!parsed) {
 		std::ostringstream oss;
-		oss <<  file_name << ": " << strerror(errno);
+		oss <<  file_name << ": error reading file";
 		
 		throw std::runtime_error(oss.str());
 	}
@@ -299,7 +286,7 @@ void prefix_closed_mining_trigat(const std::string &database_file, const std::st
 	typename std::map<unsigned int,std::list<sequence<Value1> > >::const_iterator closed_sequences_iter = closed_sequences.begin();
 	for(; closed_sequences_iter != closed_sequences.end(); ++closed_sequences_iter) {
 		const std::list<sequence<Value1> > &sequences = closed_sequences_iter->second;
-
+		
 		typename std::list<sequence<Value1> >::iterator suffixes_iter = suffixes.begin();
 		for(; suffixes_iter != suffixes.end(); ++suffixes_iter) {
 			typename std::list<sequence<Value1> >::const_iterator sequences_iter = sequences.begin();
@@ -368,7 +355,7 @@ void prefix_closed_mining_rina(const std::string &database_file, const std::stri
 template <template <typename, typename> class Miner, typename Value1, typename Value2>
 void run(double min_support, bool strip_sequences, const std::string &infile, const std::string &suffixfile, const std::string &outfile, const Miner<Value1,Value2> &miner) {
 	timer<long double> time;			
-			
+	
 	mine(infile, suffixfile, outfile, min_support, strip_sequences, miner);
 	//prefix_closed_mining_rina(infile, std::string("suffixes.dat"), min_support, strip_sequences, miner);
 	
@@ -0,0 +1,6 @@
+#include "pattern_mining.hh"
+#include "prefix_span_miner.hh"
+
+int main(int argc, char *argv[]) {
+	return run<prefix_span_miner>(argc, argv);
+}
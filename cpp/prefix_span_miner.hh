@@ -0,0 +1,534 @@
+#ifndef _PREFIX_SPAN_MINER_HH_
+#define _PREFIX_SPAN_MINER_HH_
+
+#include <iostream>
+#include <sstream>
+
+#include <list>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <algorithm>
+#include <iterator>
+
+#include "ordered_set.hh"
+#include "sequence.hh"
+#include "flat_database.hh"
+#include "sequential_pattern_miner.hh"
+
+/* PrefixSpan with pseudo-projection
+ *
+ * a projected database is a list of (sequence id, offset) pairs into a copy
+ * of the database where every item is replaced by its index in the frequent
+ * item list. each node scans its projected suffixes once, filling one bucket
+ * per item with the projection of the extended pattern, and only recurses on
+ * buckets that reach the minimum support.
+ *
+ * in closed-only mode every node runs the BIDE closure checks on its projected
+ * database: a pattern with a forward or backward extension of the same support
+ * is not closed and is not output, and a branch is pruned as a whole when an
+ * item occurs in a semi-maximum period of every projected sequence, since then
+ * no pattern below it can be closed either. closed patterns are written to the
+ * output as they are found, without being tested against the others. */
+template <typename Value1, typename Value2>
+class prefix_span_miner : public sequential_pattern_miner<Value1,Value2> {
+	public:
+		using sequential_pattern_miner<Value1,Value2>::mine;
+		
+		virtual bool supports_closed_only() const {
+			return true;
+		}
+		
+		virtual bool supports_cooccurrence_pruning() const {
+			return false;
+		}
+		
+		/* the pseudo-projections are mined depth first without tasks */
+		virtual bool supports_threads() const {
+			return false;
+		}
+		
+		#ifndef NDEBUG
+		using sequential_pattern_miner<Value1,Value2>::update_graph;
+		#endif
+		
+	protected:
+		using sequential_pattern_miner<Value1,Value2>::closed_only;
+		using sequential_pattern_miner<Value1,Value2>::write_closed;
+		
+		typedef std::vector<std::pair<unsigned int,unsigned int> > projected_database;
+		
+		virtual void mine_patterns(std::vector<const sequence<Value1> *> &database, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<Value1> &return_patterns, pattern_sink<Value1> &closed_patterns) const {
+			#ifndef NDEBUG
+			std::cerr << __FILE__ << ":" << __LINE__ << std::endl;
+			#endif
+			
+			mine_projected_patterns(database, items, min_support, return_patterns, closed_patterns);
+		}
+		
+		virtual void mine_patterns(std::vector<const sequence_view<Value1> *> &database, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<Value1> &return_patterns, pattern_sink<Value1> &closed_patterns) const {
+			#ifndef NDEBUG
+			std::cerr << __FILE__ << ":" << __LINE__ << std::endl;
+			#endif
+			
+			mine_projected_patterns(database, items, min_support, return_patterns, closed_patterns);
+		}
+		
+	private:
+		static void add_projection(projected_database &bucket, unsigned int sequence_id, unsigned int offset) {
+			if(bucket.empty() || bucket.back().first != sequence_id) {
+				bucket.push_back(std::make_pair(sequence_id, offset));
+			}
+		}
+		
+		/* whether some extension of the pattern occurs in every projected sequence */
+		static bool forward_extension(const std::vector<projected_database> &buckets, unsigned int support) {
+			std::vector<projected_database>::const_iterator buckets_iter = buckets.begin();
+			for(; buckets_iter != buckets.end(); ++buckets_iter) {
+				if(buckets_iter->size() == support) {
+					return true;
+				}
+			}
+			
+			return false;
+		}
+		
+		/* BIDE backward extension check of seq, returns false when an item occurs in
+		 * the ii-th maximum period of every projected sequence, the span between the
+		 * earliest match of the first ii items and the last match of item ii. prune
+		 * is set when it occurs in the ii-th semi-maximum period, ending at the last
+		 * match of item ii before the earliest match of the rest of seq */
+		static bool backward_closed(const flat_database<unsigned int> &database, const projected_database &projected, const sequence<Value2> &seq, const std::vector<Value2> &items, bool &prune) {
+			std::vector<unsigned int> pattern;
+			typename sequence<Value2>::const_iterator seq_iter = seq.begin();
+			for(; seq_iter != seq.end(); ++seq_iter) {
+				pattern.push_back(item_index(items, *seq_iter));
+			}
+			
+			unsigned int length = pattern.size();
+			unsigned int support = projected.size();
+			
+			std::vector<unsigned int> first(support * length);
+			std::vector<unsigned int> last_in_first(support * length);
+			std::vector<unsigned int> last_in_last(support * length);
+			for(unsigned int kk=0; kk < support; kk++) {
+				sequence_view<unsigned int> index_view = database[projected[kk].first];
+				unsigned int *tmp_first = &first[kk * length];
+				unsigned int *tmp_last_in_first = &last_in_first[kk * length];
+				unsigned int *tmp_last_in_last = &last_in_last[kk * length];
+				
+				unsigned int jj = 0;
+				for(unsigned int ii=0; ii < length; ii++, jj++) {
+					while(index_view[jj] != pattern[ii]) {
+						jj++;
+					}
+					tmp_first[ii] = jj;
+				}
+				
+				jj = tmp_first[length-1];
+				tmp_last_in_first[length-1] = jj;
+				for(unsigned int ii=length-1; ii > 0; ii--) {
+					do {
+						jj--;
+					} while(index_view[jj] != pattern[ii-1]);
+					tmp_last_in_first[ii-1] = jj;
+				}
+				
+				jj = index_view.length();
+				for(unsigned int ii=length; ii > 0; ii--) {
+					do {
+						jj--;
+					} while(index_view[jj] != pattern[ii-1]);
+					tmp_last_in_last[ii-1] = jj;
+				}
+			}
+			
+			bool closed = true;
+			prune = false;
+			
+			std::vector<unsigned int> maximum_counts(items.size());
+			std::vector<unsigned int> semi_maximum_counts(items.size());
+			std::vector<unsigned int> seen(items.size());
+			for(unsigned int ii=0; ii < length; ii++) {
+				std::fill(maximum_counts.begin(), maximum_counts.end(), 0);
+				std::fill(semi_maximum_counts.begin(), semi_maximum_counts.end(), 0);
+				std::fill(seen.begin(), seen.end(), 0);
+				
+				for(unsigned int kk=0; kk < support; kk++) {
+					sequence_view<unsigned int> index_view = database[projected[kk].first];
+					
+					unsigned int jj = (ii == 0) ? 0 : first[kk * length + ii - 1] + 1;
+					for(; jj < last_in_last[kk * length + ii]; jj++) {
+						unsigned int index = index_view[jj];
+						if(seen[index] != kk+1) {
+							seen[index] = kk+1;
+							maximum_counts[index]++;
+							if(jj < last_in_first[kk * length + ii]) {
+								semi_maximum_counts[index]++;
+							}
+						}
+					}
+				}
+				
+				for(unsigned int index=0; index < items.size(); index++) {
+					if(semi_maximum_counts[index] == support) {
+						prune = true;
+						return false;
+					}
+					else if(maximum_counts[index] == support) {
+						closed = false;
+					}
+				}
+			}
+			
+			return closed;
+		}
+		
+		/* itemset version of the backward extension check, an item can also be added
+		 * to element ii where it matches within the ii-th maximum period. pruning on
+		 * that only holds for elements before the last, which may still grow */
+		static bool backward_closed(const flat_database<ordered_set<unsigned int> > &database, const projected_database &projected, const sequence<ordered_set<Value2> > &seq, const std::vector<Value2> &items, bool &prune) {
+			std::vector<std::vector<unsigned int> > pattern;
+			typename sequence<ordered_set<Value2> >::const_iterator seq_iter = seq.begin();
+			for(; seq_iter != seq.end(); ++seq_iter) {
+				pattern.push_back(std::vector<unsigned int>());
+				
+				typename ordered_set<Value2>::const_iterator set_iter = seq_iter->begin();
+				for(; set_iter != seq_iter->end(); ++set_iter) {
+					pattern.back().push_back(item_index(items, *set_iter));
+				}
+			}
+			
+			unsigned int length = pattern.size();
+			unsigned int support = projected.size();
+			
+			std::vector<unsigned int> first(support * length);
+			std::vector<unsigned int> last_in_first(support * length);
+			std::vector<unsigned int> last_in_last(support * length);
+			for(unsigned int kk=0; kk < support; kk++) {
+				sequence_view<ordered_set<unsigned int> > index_view = database[projected[kk].first];
+				unsigned int *tmp_first = &first[kk * length];
+				unsigned int *tmp_last_in_first = &last_in_first[kk * length];
+				unsigned int *tmp_last_in_last = &last_in_last[kk * length];
+				
+				unsigned int jj = 0;
+				for(unsigned int ii=0; ii < length; ii++, jj++) {
+					while(!contains(index_view[jj], pattern[ii])) {
+						jj++;
+					}
+					tmp_first[ii] = jj;
+				}
+				
+				jj = tmp_first[length-1];
+				tmp_last_in_first[length-1] = jj;
+				for(unsigned int ii=length-1; ii > 0; ii--) {
+					do {
+						jj--;
+					} while(!contains(index_view[jj], pattern[ii-1]));
+					tmp_last_in_first[ii-1] = jj;
+				}
+				
+				jj = index_view.length();
+				for(unsigned int ii=length; ii > 0; ii--) {
+					do {
+						jj--;
+					} while(!contains(index_view[jj], pattern[ii-1]));
+					tmp_last_in_last[ii-1] = jj;
+				}
+			}
+			
+			bool closed = true;
+			prune = false;
+			
+			std::vector<unsigned int> element_counts(items.size());
+			std::vector<unsigned int> semi_element_counts(items.size());
+			std::vector<unsigned int> element_seen(items.size());
+			std::vector<unsigned int> item_counts(items.size());
+			std::vector<unsigned int> semi_item_counts(items.size());
+			std::vector<unsigned int> item_seen(items.size());
+			for(unsigned int ii=0; ii < length; ii++) {
+				std::fill(element_counts.begin(), element_counts.end(), 0);
+				std::fill(semi_element_counts.begin(), semi_element_counts.end(), 0);
+				std::fill(element_seen.begin(), element_seen.end(), 0);
+				std::fill(item_counts.begin(), item_counts.end(), 0);
+				std::fill(semi_item_counts.begin(), semi_item_counts.end(), 0);
+				std::fill(item_seen.begin(), item_seen.end(), 0);
+				
+				for(unsigned int kk=0; kk < support; kk++) {
+					sequence_view<ordered_set<unsigned int> > index_view = database[projected[kk].first];
+					unsigned int tmp_first = first[kk * length + ii];
+					unsigned int tmp_last_in_first = last_in_first[kk * length + ii];
+					unsigned int tmp_last_in_last = last_in_last[kk * length + ii];
+					
+					/* a new element between elements ii-1 and ii */
+					unsigned int jj = (ii == 0) ? 0 : first[kk * length + ii - 1] + 1;
+					for(; jj < tmp_last_in_last; jj++) {
+						set_view<unsigned int> element = index_view[jj];
+						
+						set_view<unsigned int>::const_iterator element_iter = element.begin();
+						for(; element_iter != element.end(); ++element_iter) {
+							if(element_seen[*element_iter] != kk+1) {
+								element_seen[*element_iter] = kk+1;
+								element_counts[*element_iter]++;
+								if(jj < tmp_last_in_first) {
+									semi_element_counts[*element_iter]++;
+								}
+							}
+						}
+					}
+					
+					/* an item added to element ii */
+					for(jj=tmp_first; jj <= tmp_last_in_last; jj++) {
+						set_view<unsigned int> element = index_view[jj];
+						if(!contains(element, pattern[ii])) {
+							continue;
+						}
+						
+						set_view<unsigned int>::const_iterator element_iter = element.begin();
+						for(; element_iter != element.end(); ++element_iter) {
+							if(item_seen[*element_iter] != kk+1 && !std::binary_search(pattern[ii].begin(), pattern[ii].end(), *element_iter)) {
+								item_seen[*element_iter] = kk+1;
+								item_counts[*element_iter]++;
+								if(jj <= tmp_last_in_first) {
+									semi_item_counts[*element_iter]++;
+								}
+							}
+						}
+					}
+				}
+				
+				for(unsigned int index=0; index < items.size(); index++) {
+					if(semi_element_counts[index] == support || (ii+1 < length && semi_item_counts[index] == support)) {
+						prune = true;
+						return false;
+					}
+					else if(element_counts[index] == support || item_counts[index] == support) {
+						closed = false;
+					}
+				}
+			}
+			
+			return closed;
+		}
+		
+		static bool contains(const set_view<unsigned int> &element, const std::vector<unsigned int> &items) {
+			return std::includes(element.begin(), element.end(), items.begin(), items.end());
+		}
+		
+		template <typename Sequence>
+		void mine_projected_patterns(std::vector<const Sequence *> &database, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<Value2> &return_patterns, pattern_sink<Value2> &closed_patterns) const {
+			flat_database<unsigned int> index_database;
+			sequence<unsigned int> index_seq;
+			
+			typename std::vector<const Sequence *>::iterator database_iter = database.begin();
+			for(; database_iter != database.end(); ++database_iter) {
+				index_seq.clear();
+				
+				typename Sequence::const_iterator seq_iter = (*database_iter)->begin();
+				for(; seq_iter != (*database_iter)->end(); ++seq_iter) {
+					unsigned int index = item_index(items, *seq_iter);
+					if(index < items.size()) {
+						index_seq.push_element(index);
+					}
+				}
+				
+				index_database.push_back(index_seq);
+			}
+			
+			projected_database projected;
+			projected.reserve(index_database.size());
+			for(unsigned int ii=0; ii < index_database.size(); ii++) {
+				projected.push_back(std::make_pair(ii, 0u));
+			}
+			
+			sequence<Value2> seq;
+			mine_patterns(index_database, projected, seq, items, min_support, return_patterns, closed_patterns);
+		}
+		
+		template <typename Sequence>
+		void mine_projected_patterns(std::vector<const Sequence *> &database, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<ordered_set<Value2> > &return_patterns, pattern_sink<ordered_set<Value2> > &closed_patterns) const {
+			typedef typename std::iterator_traits<typename Sequence::const_iterator>::value_type set_type;
+			
+			flat_database<ordered_set<unsigned int> > index_database;
+			sequence<ordered_set<unsigned int> > index_seq;
+			
+			typename std::vector<const Sequence *>::iterator database_iter = database.begin();
+			for(; database_iter != database.end(); ++database_iter) {
+				index_seq.clear();
+				
+				typename Sequence::const_iterator seq_iter = (*database_iter)->begin();
+				for(; seq_iter != (*database_iter)->end(); ++seq_iter) {
+					const set_type &tmp_set = *seq_iter;
+					
+					index_seq.push_element(ordered_set<unsigned int>());
+					
+					typename set_type::const_iterator tmp_set_iter = tmp_set.begin();
+					for(; tmp_set_iter != tmp_set.end(); ++tmp_set_iter) {
+						unsigned int index = item_index(items, *tmp_set_iter);
+						if(index < items.size()) {
+							index_seq.push_item(index);
+						}
+					}
+				}
+				
+				index_database.push_back(index_seq);
+			}
+			
+			std::vector<projected_database> buckets(items.size());
+			for(unsigned int ii=0; ii < index_database.size(); ii++) {
+				sequence_view<ordered_set<unsigned int> > index_view = index_database[ii];
+				for(unsigned int jj=0; jj < index_view.length(); jj++) {
+					set_view<unsigned int> element = index_view[jj];
+					
+					set_view<unsigned int>::const_iterator element_iter = element.begin();
+					for(; element_iter != element.end(); ++element_iter) {
+						add_projection(buckets[*element_iter], ii, jj);
+					}
+				}
+			}
+			
+			sequence<ordered_set<Value2> > seq;
+			std::vector<unsigned int> last_set;
+			for(unsigned int ii=0; ii < items.size(); ii++) {
+				if(buckets[ii].size() >= min_support) {
+					seq.push_element(ordered_set<Value2>());
+					seq.push_item(items[ii]);
+					last_set.push_back(ii);
+					
+					#ifndef NDEBUG
+					update_graph(seq, items);
+					#endif
+					
+					mine_patterns(index_database, buckets[ii], seq, last_set, items, min_support, return_patterns, closed_patterns);
+					
+					last_set.pop_back();
+					seq.pop_element();
+				}
+			}
+		}
+		
+		/* offsets point just past the earliest match of seq */
+		void mine_patterns(const flat_database<unsigned int> &database, const projected_database &projected, sequence<Value2> &seq, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<Value2> &return_patterns, pattern_sink<Value2> &closed_patterns) const {
+			bool closed = false;
+			if(!seq.empty()) {
+				if(closed_only) {
+					bool prune;
+					closed = backward_closed(database, projected, seq, items, prune);
+					if(prune) {
+						return;
+					}
+				}
+				else {
+					maintain_and_test(seq, projected.size(), return_patterns);
+				}
+			}
+			
+			std::vector<projected_database> buckets(items.size());
+			
+			projected_database::const_iterator projected_iter = projected.begin();
+			for(; projected_iter != projected.end(); ++projected_iter) {
+				sequence_view<unsigned int> index_view = database[projected_iter->first];
+				for(unsigned int jj=projected_iter->second; jj < index_view.length(); jj++) {
+					add_projection(buckets[index_view[jj]], projected_iter->first, jj+1);
+				}
+			}
+			
+			if(closed && !forward_extension(buckets, projected.size())) {
+				write_closed(closed_patterns, seq, projected.size());
+			}
+			
+			for(unsigned int ii=0; ii < items.size(); ii++) {
+				if(buckets[ii].size() >= min_support) {
+					seq.push_element(items[ii]);
+					
+					#ifndef NDEBUG
+					update_graph(seq, items);
+					#endif
+					
+					mine_patterns(database, buckets[ii], seq, items, min_support, return_patterns, closed_patterns);
+					
+					seq.pop_element();
+				}
+			}
+		}
+		
+		/* offsets point at the earliest itemset containing last_set, the item indices of the last element of seq */
+		void mine_patterns(const flat_database<ordered_set<unsigned int> > &database, const projected_database &projected, sequence<ordered_set<Value2> > &seq, std::vector<unsigned int> &last_set, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<ordered_set<Value2> > &return_patterns, pattern_sink<ordered_set<Value2> > &closed_patterns) const {
+			bool closed = false;
+			if(closed_only) {
+				bool prune;
+				closed = backward_closed(database, projected, seq, items, prune);
+				if(prune) {
+					return;
+				}
+			}
+			else {
+				maintain_and_test(seq, projected.size(), return_patterns);
+			}
+			
+			std::vector<projected_database> item_buckets(items.size());
+			std::vector<projected_database> element_buckets(items.size());
+			
+			projected_database::const_iterator projected_iter = projected.begin();
+			for(; projected_iter != projected.end(); ++projected_iter) {
+				sequence_view<ordered_set<unsigned int> > index_view = database[projected_iter->first];
+				for(unsigned int jj=projected_iter->second; jj < index_view.length(); jj++) {
+					set_view<unsigned int> element = index_view[jj];
+					
+					if(jj == projected_iter->second || std::includes(element.begin(), element.end(), last_set.begin(), last_set.end())) {
+						set_view<unsigned int>::const_iterator element_iter = std::upper_bound(element.begin(), element.end(), last_set.back());
+						for(; element_iter != element.end(); ++element_iter) {
+							add_projection(item_buckets[*element_iter], projected_iter->first, jj);
+						}
+					}
+					
+					if(jj > projected_iter->second) {
+						set_view<unsigned int>::const_iterator element_iter = element.begin();
+						for(; element_iter != element.end(); ++element_iter) {
+							add_projection(element_buckets[*element_iter], projected_iter->first, jj);
+						}
+					}
+				}
+			}
+			
+			if(closed && !forward_extension(item_buckets, projected.size()) && !forward_extension(element_buckets, projected.size())) {
+				write_closed(closed_patterns, seq, projected.size());
+			}
+			
+			for(unsigned int ii=0; ii < items.size(); ii++) {
+				if(item_buckets[ii].size() >= min_support) {
+					seq.push_item(items[ii]);
+					last_set.push_back(ii);
+					
+					#ifndef NDEBUG
+					update_graph(seq, items);
+					#endif
+					
+					mine_patterns(database, item_buckets[ii], seq, last_set, items, min_support, return_patterns, closed_patterns);
+					
+					last_set.pop_back();
+					seq.pop_item();
+				}
+			}
+			
+			std::vector<unsigned int> element_set(1);
+			for(unsigned int ii=0; ii < items.size(); ii++) {
+				if(element_buckets[ii].size() >= min_support) {
+					seq.push_element(ordered_set<Value2>());
+					seq.push_item(items[ii]);
+					element_set[0] = ii;
+					
+					#ifndef NDEBUG
+					update_graph(seq, items);
+					#endif
+					
+					mine_patterns(database, element_buckets[ii], seq, element_set, items, min_support, return_patterns, closed_patterns);
+					
+					seq.pop_element();
+				}
+			}
+		}
+};
+
+#endif
@@ -0,0 +1,474 @@
+#ifndef _PROJECTED_DATABASE_HH_
+#define _PROJECTED_DATABASE_HH_
+
+#include <vector>
+
+#include <utility>
+
+#include <algorithm>
+
+#include "ordered_set.hh"
+#include "sequence.hh"
+#include "position_index.hh"
+
+/* the sequences of a database projected along the pattern being mined
+ *
+ * two parallel arrays, the numbers of the sequences supporting the pattern
+ * after depth projections and their positions, in row depth of one arena with
+ * a row of sequences.size() slots per depth. projecting reads the first count
+ * slots of a row and writes the sequences that hold the item to the front of
+ * the next, so going back up the tree leaves nothing to undo and the rows are
+ * read and written in order. Sequence is any sequence type (i.e., sequence or
+ * sequence_view) holding T elements. with position indexes, projections jump
+ * to the next occurrence of an item instead of scanning for it */
+template <typename T, typename Sequence = sequence<T> >
+class projected_database {
+	public:
+		projected_database() : sequences(), indexes(), ids(), positions() {
+			
+		}
+		
+		explicit projected_database(const std::vector<const Sequence *> &database) : sequences(database), indexes(), ids(), positions() {
+			start();
+		}
+		
+		static bool indexable() {
+			return true;
+		}
+		
+		static bool closable() {
+			return true;
+		}
+		
+		static bool recountable() {
+			return true;
+		}
+		
+		/* builds a position index of every sequence into index_store */
+		void index(std::vector<position_index<T> > &index_store) {
+			index_store.resize(sequences.size());
+			indexes.resize(sequences.size());
+			for(std::size_t ii=0; ii < sequences.size(); ii++) {
+				position_index<T>(*sequences[ii]).swap(index_store[ii]);
+				indexes[ii] = &index_store[ii];
+			}
+		}
+		
+		/* the first count sequences of database as projected at depth, which
+		 * become depth 0 here */
+		void assign(const projected_database &database, unsigned int depth, unsigned int count) {
+			sequences.clear();
+			indexes.clear();
+			for(unsigned int ii=0; ii < count; ii++) {
+				sequences.push_back(database.sequences[database.id(depth, ii)]);
+				if(!database.indexes.empty()) {
+					indexes.push_back(database.indexes[database.id(depth, ii)]);
+				}
+			}
+			start();
+			
+			std::copy(database.position_row(depth), database.position_row(depth) + count, position_row(0));
+		}
+		
+		unsigned int size() const {
+			return sequences.size();
+		}
+		
+		/* projects the first count sequences from depth to depth+1 after the
+		 * next item, returning the number of those that hold it */
+		unsigned int project(unsigned int depth, unsigned int count, const T &item) {
+			reserve(depth + 1);
+			const unsigned int *from_ids = id_row(depth), *from = position_row(depth);
+			unsigned int *to_ids = id_row(depth + 1), *to = position_row(depth + 1);
+			
+			unsigned int projected = 0;
+			for(unsigned int ii=0; ii < count; ii++) {
+				unsigned int position = from[ii];
+				if(next(from_ids[ii], item, position)) {
+					to_ids[projected] = from_ids[ii];
+					to[projected++] = position;
+				}
+			}
+			
+			return projected;
+		}
+		
+		/* adds the items of the sequence in slot ii after its projection at depth
+		 * to counter */
+		template <typename Counter>
+		void count_extensions(unsigned int depth, unsigned int ii, Counter &counter) const {
+			const Sequence &seq = *sequences[id(depth, ii)];
+			
+			counter.next_sequence();
+			counter.add(seq.begin() + position_row(depth)[ii], seq.end());
+		}
+		
+		/* BIDE backward extension check of pattern over the first count sequences
+		 * at depth, returns false when an item occurs in the ii-th maximum period
+		 * of every one of them, the span between the first instance of the first
+		 * ii items and the last instance of item ii. prune is set when it occurs
+		 * in the ii-th semi-maximum period, ending at the last match of item ii
+		 * before the first instance of the rest of pattern */
+		bool backward_closed(unsigned int depth, unsigned int count, const sequence<T> &pattern, bool &prune) const {
+			unsigned int length = pattern.length();
+			
+			std::vector<unsigned int> first(count * length);
+			std::vector<unsigned int> last_in_first(count * length);
+			std::vector<unsigned int> last_in_last(count * length);
+			for(unsigned int kk=0; kk < count; kk++) {
+				const Sequence &seq = *sequences[id(depth, kk)];
+				unsigned int *tmp_first = &first[kk * length];
+				unsigned int *tmp_last_in_first = &last_in_first[kk * length];
+				unsigned int *tmp_last_in_last = &last_in_last[kk * length];
+				
+				unsigned int jj = 0;
+				for(unsigned int ii=0; ii < length; ii++, jj++) {
+					while(seq[jj] != pattern[ii]) {
+						jj++;
+					}
+					tmp_first[ii] = jj;
+				}
+				
+				jj = tmp_first[length-1];
+				tmp_last_in_first[length-1] = jj;
+				for(unsigned int ii=length-1; ii > 0; ii--) {
+					do {
+						jj--;
+					} while(seq[jj] != pattern[ii-1]);
+					tmp_last_in_first[ii-1] = jj;
+				}
+				
+				jj = seq.length();
+				for(unsigned int ii=length; ii > 0; ii--) {
+					do {
+						jj--;
+					} while(seq[jj] != pattern[ii-1]);
+					tmp_last_in_last[ii-1] = jj;
+				}
+			}
+			
+			bool closed = true;
+			prune = false;
+			if(count == 0) {
+				return closed;
+			}
+			
+			/* only the items of the period in the first sequence can occur in all */
+			std::vector<T> candidates;
+			std::vector<unsigned int> maximum_counts, semi_maximum_counts, seen;
+			for(unsigned int ii=0; ii < length; ii++) {
+				const Sequence &front = *sequences[id(depth, 0)];
+				candidates.assign(front.begin() + period_start(first, length, 0, ii), front.begin() + last_in_last[ii]);
+				std::sort(candidates.begin(), candidates.end());
+				candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+				
+				maximum_counts.assign(candidates.size(), 0);
+				semi_maximum_counts.assign(candidates.size(), 0);
+				seen.assign(candidates.size(), 0);
+				
+				for(unsigned int kk=0; kk < count; kk++) {
+					const Sequence &seq = *sequences[id(depth, kk)];
+					
+					unsigned int jj = period_start(first, length, kk, ii);
+					for(; jj < last_in_last[kk * length + ii]; jj++) {
+						typename std::vector<T>::const_iterator candidates_iter = std::lower_bound(candidates.begin(), candidates.end(), seq[jj]);
+						if(candidates_iter == candidates.end() || seq[jj] < *candidates_iter) {
+							continue;
+						}
+						
+						unsigned int index = candidates_iter - candidates.begin();
+						if(seen[index] != kk+1) {
+							seen[index] = kk+1;
+							maximum_counts[index]++;
+							if(jj < last_in_first[kk * length + ii]) {
+								semi_maximum_counts[index]++;
+							}
+						}
+					}
+				}
+				
+				for(unsigned int index=0; index < candidates.size(); index++) {
+					if(semi_maximum_counts[index] == count) {
+						prune = true;
+						return false;
+					}
+					else if(maximum_counts[index] == count) {
+						closed = false;
+					}
+				}
+			}
+			
+			return closed;
+		}
+		
+	private:
+		std::vector<const Sequence *> sequences;
+		std::vector<const position_index<T> *> indexes;
+		std::vector<unsigned int> ids;
+		std::vector<unsigned int> positions;
+		
+		/* only the root row, deeper rows are added by reserve as the search reaches them */
+		void start() {
+			ids.assign(sequences.size(), 0);
+			positions.assign(sequences.size(), 0);
+			for(unsigned int ii=0; ii < sequences.size(); ii++) {
+				ids[ii] = ii;
+			}
+		}
+		
+		/* makes room for the rows up to depth */
+		void reserve(unsigned int depth) {
+			std::size_t size = (std::size_t) (depth + 1) * sequences.size();
+			if(positions.size() < size) {
+				ids.resize(size);
+				positions.resize(size);
+			}
+		}
+		
+		unsigned int id(unsigned int depth, unsigned int ii) const {
+			return ids[(std::size_t) depth * sequences.size() + ii];
+		}
+		
+		unsigned int * id_row(unsigned int depth) {
+			return ids.empty() ? NULL : &ids[0] + (std::size_t) depth * sequences.size();
+		}
+		
+		unsigned int * position_row(unsigned int depth) {
+			return positions.empty() ? NULL : &positions[0] + (std::size_t) depth * sequences.size();
+		}
+		
+		const unsigned int * position_row(unsigned int depth) const {
+			return positions.empty() ? NULL : &positions[0] + (std::size_t) depth * sequences.size();
+		}
+		
+		/* the ii-th period of sequence kk starts after the first instance of the
+		 * first ii items of the pattern */
+		static unsigned int period_start(const std::vector<unsigned int> &first, unsigned int length, unsigned int kk, unsigned int ii) {
+			return (ii == 0) ? 0 : first[kk * length + ii - 1] + 1;
+		}
+		
+		/* moves position after the next item in sequence id, if there is one */
+		bool next(unsigned int id, const T &item, unsigned int &position) const {
+			const Sequence &seq = *sequences[id];
+			
+			if(!indexes.empty()) {
+				position = indexes[id]->next(item, position);
+				if(position == position_index<T>::npos) {
+					return false;
+				}
+			}
+			else {
+				typename Sequence::const_iterator seq_iter = std::find(seq.begin() + position, seq.end(), item);
+				if(seq_iter == seq.end()) {
+					return false;
+				}
+				position = seq_iter - seq.begin();
+			}
+			
+			position++;
+			return true;
+		}
+};
+
+/* for itemsets a position is an element and the offset into it after the
+ * last projected item */
+template <typename T, typename Sequence>
+class projected_database<ordered_set<T>,Sequence> {
+	public:
+		projected_database() : sequences(), ids(), positions() {
+			
+		}
+		
+		explicit projected_database(const std::vector<const Sequence *> &database) : sequences(database), ids(), positions() {
+			start();
+		}
+		
+		/* sequences of itemsets are not indexed, their projections search a sorted
+		 * element or step to the next element, which the index does not speed up */
+		static bool indexable() {
+			return false;
+		}
+		
+		/* a set projection gives up at the first later element holding a larger
+		 * item, so the BIDE periods do not describe its matches */
+		static bool closable() {
+			return false;
+		}
+		
+		/* for the same reason a pattern can occur in a sequence where one of its
+		 * subpatterns does not, so the items counted after a projection are not
+		 * the candidates a search without local counts hands down */
+		static bool recountable() {
+			return false;
+		}
+		
+		void index(std::vector<position_index<ordered_set<T> > > &) {
+			
+		}
+		
+		void assign(const projected_database &database, unsigned int depth, unsigned int count) {
+			sequences.clear();
+			for(unsigned int ii=0; ii < count; ii++) {
+				sequences.push_back(database.sequences[database.id(depth, ii)]);
+			}
+			start();
+			
+			std::copy(database.position_row(depth), database.position_row(depth) + count, position_row(0));
+		}
+		
+		unsigned int size() const {
+			return sequences.size();
+		}
+		
+		/* adds item to the projected elements of the first count sequences */
+		unsigned int project_item(unsigned int depth, unsigned int count, const T &item) {
+			return project(depth, count, item, &projected_database::next_item);
+		}
+		
+		/* projects the first count sequences to the first later element starting
+		 * with the items up to item and holding item */
+		unsigned int project_set(unsigned int depth, unsigned int count, const T &item) {
+			return project(depth, count, item, &projected_database::next_set);
+		}
+		
+		/* adds the items after the projection at depth in its element to
+		 * set_counter, and the items of the elements after it to sequence_counter */
+		template <typename Counter>
+		void count_extensions(unsigned int depth, unsigned int ii, Counter &set_counter, Counter &sequence_counter) const {
+			set_counter.next_sequence();
+			sequence_counter.next_sequence();
+			
+			const Sequence &seq = *sequences[id(depth, ii)];
+			const position_type &position = position_row(depth)[ii];
+			if(position.first >= seq.length()) {
+				return;
+			}
+			
+			add_items(seq[position.first], position.second, set_counter);
+			for(unsigned int element = position.first + 1; element < seq.length(); element++) {
+				add_items(seq[element], 0, sequence_counter);
+			}
+		}
+		
+	private:
+		typedef std::pair<unsigned int,unsigned int> position_type;
+		
+		std::vector<const Sequence *> sequences;
+		std::vector<unsigned int> ids;
+		std::vector<position_type> positions;
+		
+		/* only the root row, deeper rows are added by reserve as the search reaches them */
+		void start() {
+			ids.assign(sequences.size(), 0);
+			positions.assign(sequences.size(), position_type(0, 0));
+			for(unsigned int ii=0; ii < sequences.size(); ii++) {
+				ids[ii] = ii;
+			}
+		}
+		
+		void reserve(unsigned int depth) {
+			std::size_t size = (std::size_t) (depth + 1) * sequences.size();
+			if(positions.size() < size) {
+				ids.resize(size);
+				positions.resize(size);
+			}
+		}
+		
+		unsigned int id(unsigned int depth, unsigned int ii) const {
+			return ids[(std::size_t) depth * sequences.size() + ii];
+		}
+		
+		unsigned int * id_row(unsigned int depth) {
+			return ids.empty() ? NULL : &ids[0] + (std::size_t) depth * sequences.size();
+		}
+		
+		position_type * position_row(unsigned int depth) {
+			return positions.empty() ? NULL : &positions[0] + (std::size_t) depth * sequences.size();
+		}
+		
+		const position_type * position_row(unsigned int depth) const {
+			return positions.empty() ? NULL : &positions[0] + (std::size_t) depth * sequences.size();
+		}
+		
+		unsigned int project(unsigned int depth, unsigned int count, const T &item, bool (projected_database::*next)(unsigned int, const T &, position_type &) const) {
+			reserve(depth + 1);
+			const unsigned int *from_ids = id_row(depth);
+			const position_type *from = position_row(depth);
+			unsigned int *to_ids = id_row(depth + 1);
+			position_type *to = position_row(depth + 1);
+			
+			unsigned int projected = 0;
+			for(unsigned int ii=0; ii < count; ii++) {
+				position_type position = from[ii];
+				if((this->*next)(from_ids[ii], item, position)) {
+					to_ids[projected] = from_ids[ii];
+					to[projected++] = position;
+				}
+			}
+			
+			return projected;
+		}
+		
+		/* elements are sorted, the item is found by binary search */
+		bool next_item(unsigned int id, const T &item, position_type &position) const {
+			const Sequence &seq = *sequences[id];
+			if(position.first >= seq.length()) {
+				return false;
+			}
+			
+			return find_item(seq[position.first], position.second, item);
+		}
+		
+		/* stops at the first element holding a larger item before item */
+		bool next_set(unsigned int id, const T &item, position_type &position) const {
+			const Sequence &seq = *sequences[id];
+			
+			for(position.first++; position.first < seq.length(); position.first++) {
+				position.second = 0;
+				int found = scan_item(seq[position.first], position.second, item);
+				if(found > 0) {
+					return true;
+				}
+				else if(found < 0) {
+					return false;
+				}
+			}
+			
+			return false;
+		}
+		
+		template <typename Set>
+		static bool find_item(const Set &set, unsigned int &offset, const T &item) {
+			typename Set::const_iterator set_iter = std::lower_bound(set.begin() + offset, set.end(), item);
+			if(set_iter == set.end() || item < *set_iter) {
+				return false;
+			}
+			
+			offset = set_iter - set.begin() + 1;
+			return true;
+		}
+		
+		/* 1 with offset after item when set holds it, -1 when a larger item comes
+		 * first, 0 otherwise */
+		template <typename Set>
+		static int scan_item(const Set &set, unsigned int &offset, const T &item) {
+			for(; offset < set.size(); offset++) {
+				if(set[offset] == item) {
+					offset++;
+					return 1;
+				}
+				else if(set[offset] > item) {
+					return -1;
+				}
+			}
+			
+			return 0;
+		}
+		
+		template <typename Set, typename Counter>
+		static void add_items(const Set &set, unsigned int offset, Counter &counter) {
+			counter.add(set.begin() + offset, set.end());
+		}
+};
+
+#endif
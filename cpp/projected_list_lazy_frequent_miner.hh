@@ -16,245 +16,151 @@
 
 #include "ordered_set.hh"
 #include "sequence.hh"
+#include "projected_database.hh"
 #include "sequential_pattern_miner.hh"
 
-template <typename T>
-class projected_sequence {
+template <typename Value1, typename Value2>
+class projected_list_lazy_frequent_miner : public sequential_pattern_miner<Value1,Value2> {
 	public:
-		projected_sequence() : seq(NULL) {
+		using sequential_pattern_miner<Value1,Value2>::mine;
 		
+		virtual bool supports_position_indexing() const {
+			return projected_database<Value1,sequence<Value1> >::indexable();
 		}
 		
-		projected_sequence(const sequence<T> &seq) : seq(&seq), projections() {
-			const_iterator iter = projected_sequence::seq->begin();
-			projections.push_back(iter);
+		virtual bool supports_closed_only() const {
+			return projected_database<Value1,sequence<Value1> >::closable();
 		}
 		
-		projected_sequence(const sequence<T> *seq) : seq(seq), projections() {
-			const_iterator iter = projected_sequence::seq->begin();
-			projections.push_back(iter);
+		virtual bool supports_local_counting() const {
+			return projected_database<Value1,sequence<Value1> >::recountable();
 		}
 		
-		projected_sequence & operator=(const projected_sequence &other) {
-			seq = other.seq;
-			projections = other.projections;
-			
-			return *this;
-		}
+	protected:
+		using sequential_pattern_miner<Value1,Value2>::spawn_tasks;
+		using sequential_pattern_miner<Value1,Value2>::create_task;
+		using sequential_pattern_miner<Value1,Value2>::merge_tasks;
+		using sequential_pattern_miner<Value1,Value2>::cooccurrences;
+		using sequential_pattern_miner<Value1,Value2>::position_indexing;
+		using sequential_pattern_miner<Value1,Value2>::closed_only;
+		using sequential_pattern_miner<Value1,Value2>::write_closed;
+		using sequential_pattern_miner<Value1,Value2>::local_counting;
 		
-		bool project(const T &item) {
-			const_iterator iter = projections.back();
-			while(iter != seq->end()) {
-				if(*iter == item) {
-					++iter;
-					projections.push_back(iter);
-					return true;
-				}
-				
-				++iter;
-			}
+		virtual void mine_patterns(std::vector<const sequence<Value1> *> &database, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<Value1> &return_patterns, pattern_sink<Value1> &closed_patterns) const {
+			#ifndef NDEBUG
+			std::cerr << __FILE__ << ":" << __LINE__ << std::endl;
+			#endif
 			
-			return false;
-		}
-		
-		void pop_projection() {
-			projections.pop_back();
-		}
-		
-		void swap(projected_sequence &other) {
-			std::swap(seq, other.seq);
-			std::swap(projections, other.projections);
+			mine_projected_patterns(database, items, min_support, return_patterns, closed_patterns);
 		}
 		
-	protected:
-		typedef typename sequence<T>::const_iterator const_iterator;
-		
-		const sequence<T> *seq;
-		std::vector<const_iterator> projections;
-};
-
-template <typename Value1, typename Value2>
-struct project_sequence {
-	const Value2 &item;
-	project_sequence(const Value2 &item) : item(item) {
-	
-	}
-	bool operator()(projected_sequence<Value1> &seq) const {
-		return seq.project(item);
-	}
-};
-
-template <typename T>
-class projected_sequence<ordered_set<T> > {
-	public:
-		projected_sequence() : seq(NULL) {
-		
+		virtual void mine_patterns(std::vector<const sequence_view<Value1> *> &database, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<Value1> &return_patterns, pattern_sink<Value1> &closed_patterns) const {
+			#ifndef NDEBUG
+			std::cerr << __FILE__ << ":" << __LINE__ << std::endl;
+			#endif
+			
+			mine_projected_patterns(database, items, min_support, return_patterns, closed_patterns);
 		}
 		
-		projected_sequence(const sequence<ordered_set<T> > &seq) : seq(&seq), projections() {
-			std::pair<sequence_iterator,set_iterator> iter;
-			iter.first = projected_sequence::seq->begin();
-			if(iter.first != projected_sequence::seq->end()) {
-				iter.second = iter.first.begin();
+	private:
+		/* the candidates that occur after seq in at least min_support of the
+		 * projected sequences, counted before trying any of them */
+		template <typename Database>
+		void count_local_items(const Database &database, unsigned int depth, unsigned int support, const sequence<Value2> &, const std::vector<Value2> &items, unsigned int min_support, std::vector<Value2> &frequent_items) const {
+			local_item_counter<Value2> counter(items);
+			for(unsigned int ii=0; ii < support; ii++) {
+				database.count_extensions(depth, ii, counter);
 			}
 			
-			projections.push_back(iter);
+			local_frequent_items(items, counter, min_support, frequent_items);
 		}
 		
-		projected_sequence(const sequence<ordered_set<T> > *seq) : seq(seq), projections() {
-			std::pair<sequence_iterator,set_iterator> iter;
-			iter.first = projected_sequence::seq->begin();
-			if(projected_sequence::seq->begin() != projected_sequence::seq->end()) {
-				iter.second = iter.first->begin();
+		/* for itemsets, the candidates to grow the last element of seq, the
+		 * candidates for a new element, and the items that are either */
+		template <typename Database>
+		void count_local_items(const Database &database, unsigned int depth, unsigned int support, const sequence<ordered_set<Value2> > &, const std::vector<Value2> &items, unsigned int min_support, std::vector<Value2> &set_items, std::vector<Value2> &frequent_items, std::vector<Value2> &local_items) const {
+			local_item_counter<Value2> set_counter(items), sequence_counter(items);
+			for(unsigned int ii=0; ii < support; ii++) {
+				database.count_extensions(depth, ii, set_counter, sequence_counter);
 			}
 			
-			projections.push_back(iter);
-		}
-		
-		projected_sequence & operator=(const projected_sequence &other) {
-			seq = other.seq;
-			projections = other.projections;
+			local_frequent_items(items, set_counter, min_support, set_items);
+			local_frequent_items(items, sequence_counter, min_support, frequent_items);
 			
-			return *this;
+			local_items.clear();
+			typename std::vector<Value2>::const_iterator items_iter = items.begin();
+			for(; items_iter != items.end(); ++items_iter) {
+				if(set_counter.frequent(*items_iter, min_support) || sequence_counter.frequent(*items_iter, min_support)) {
+					local_items.push_back(*items_iter);
+				}
+			}
 		}
 		
-		bool project_item(const T &item) {
-			std::pair<sequence_iterator,set_iterator> iter = projections.back();
-			while(iter.second != iter.first->end()) {
-				// TRY? iter.second = lower_bound(iter.second, iter.first->end(), item)
-				if(*(iter.second) == item) {
-					++iter.second;
-					projections.push_back(iter);
-					
-					return true;
-				}
-				else if(*(iter.second) > item) {
-					return false;
-				}
-				
-				++iter.second;
+		template <typename Sequence>
+		void mine_projected_patterns(std::vector<const Sequence *> &database, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<Value1> &return_patterns, pattern_sink<Value1> &closed_patterns) const {
+			std::vector<position_index<Value1> > indexes;
+			projected_database<Value1,Sequence> projected(database);
+			if(position_indexing) {
+				projected.index(indexes);
 			}
 			
-			return false;
+			mine_patterns(projected, items, min_support, return_patterns, closed_patterns);
 		}
 		
-		bool project_set(const T &item) {
-			std::pair<sequence_iterator,set_iterator> iter = projections.back();
-			if(iter.first != seq->end()) {
-				++iter.first;
-				
-				if(iter.first != seq->end()) {
-					iter.second = iter.first->begin();
+		template <typename Database>
+		void mine_patterns(Database &database, unsigned int depth, unsigned int support, sequence<Value2> &seq, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<Value2> &return_patterns, pattern_sink<Value2> &closed_patterns) const {
+			//std::cout << support << " " << seq << std::endl;
+			bool closed = false;
+			if(closed_only) {
+				bool prune;
+				closed = database.backward_closed(depth, support, seq, prune);
+				if(prune) {
+					return;
 				}
 			}
-			
-			while(iter.first != seq->end()) {
-				while(iter.second != iter.first->end()) {
-					// TRY? iter.second = lower_bound(iter.second, iter.first->end(), item)
-					if(*(iter.second) == item) {
-						++iter.second;
-						projections.push_back(iter);
-						
-						return true;
-					}
-					else if(*(iter.second) > item) {
-						return false;
-					}
-					
-					++iter.second;
-				}
-				
-				
-				iter.second = (++iter.first)->begin();
+			else {
+				maintain_and_test(seq, support, return_patterns);
 			}
 			
-			return false;
-		}
-		
-		void pop_projection() {
-			projections.pop_back();
-		}
-		
-		void swap(projected_sequence &other) {
-			std::swap(seq, other.seq);
-			std::swap(projections, other.projections);
-		}
-		
-	protected:
-		typedef typename sequence<ordered_set<T> >::const_iterator sequence_iterator;
-		typedef typename ordered_set<T>::const_iterator set_iterator;
-		const sequence<ordered_set<T> > *seq;
-		std::vector<std::pair<sequence_iterator,set_iterator> > projections;
-};
-
-template <typename Value1, typename Value2>
-struct project_item {
-	const Value2 &item;
-	project_item(const Value2 &item) : item(item) {
-	
-	}
-	bool operator()(projected_sequence<Value1> &seq) const {
-		return seq.project_item(item);
-	}
-};
-
-template <typename Value1, typename Value2>
-struct project_set {
-	const Value2 &item;
-	project_set(const Value2 &item) : item(item) {
-	
-	}
-	bool operator()(projected_sequence<Value1> &seq) const {
-		return seq.project_set(item);
-	}
-};
-
-template <typename T>
-void swap(projected_sequence<T> &x, projected_sequence<T> &y) {
-	x.swap(y);
-}
-
-template <typename Value1, typename Value2>
-class projected_list_lazy_frequent_miner : public sequential_pattern_miner<Value1,Value2> {
-	public:
-		using sequential_pattern_miner<Value1,Value2>::mine;
-		
-	protected:
-		
-		virtual void mine_patterns(std::vector<const sequence<Value1> *> &database, const std::vector<Value2> &items, unsigned int min_support, std::map<unsigned int,std::list<sequence<Value1> > > &return_patterns) const {
-			#ifndef NDEBUG
-			std::cerr << __FILE__ << ":" << __LINE__ << std::endl;
-			#endif
-			
-			std::vector<projected_sequence<Value1> > projected_database;
-			projected_database.reserve(database.size());
-			
-			typename std::vector<const sequence<Value1> *>::iterator database_iter = database.begin();
-			for(; database_iter != database.end(); ++database_iter) {
-				projected_database.push_back(projected_sequence<Value1>(*database_iter));
+			std::vector<Value2> frequent_items;
+			if(local_counting) {
+				count_local_items(database, depth, support, seq, items, min_support, frequent_items);
+			}
+			else {
+				frequent_items = items;
 			}
 			
-			mine_patterns(projected_database.begin(), projected_database.end(), items, min_support, return_patterns);
-		}
-		
-	private:
-		void mine_patterns(typename std::vector<projected_sequence<Value2> >::iterator db_begin, typename std::vector<projected_sequence<Value2> >::iterator db_end, sequence<Value2> &seq, const std::vector<Value2> &items, unsigned int min_support, std::map<unsigned int,std::list<sequence<Value2> > > &return_patterns) const {
-			//std::cout << std::distance(db_begin, db_end) << " " << seq << std::endl;
-			maintain_and_test(seq, std::distance(db_begin, db_end), return_patterns);
-			
-			std::vector<Value2> frequent_items(items);
+			typedef typename sequential_pattern_miner<Value1,Value2>::template projected_task<Database,Value2> task_type;
+			std::list<task_type> tasks;
+			bool spawn = spawn_tasks(support);
+			pattern_sink<Value2> *sink = &closed_patterns;
 			
-			typename std::vector<projected_sequence<Value2> >::iterator tmp_iter;
-			typename std::vector<projected_sequence<Value2> >::iterator end_iter;
+			unsigned int projected_support;
 			typename std::vector<Value2>::iterator frequent_items_iter = frequent_items.begin();
 			while(frequent_items_iter != frequent_items.end()) {
+				if(!cooccurrences.sequence_extension(seq.last(), *frequent_items_iter)) {
+					std::swap(*frequent_items_iter, frequent_items.back());
+					frequent_items.pop_back();
+					continue;
+				}
+				
 				seq.push_element(*frequent_items_iter);
 				
 				//project_sequence tester(*frequent_items_iter);
-				end_iter = std::partition(db_begin, db_end, project_sequence<Value1,Value2>(*frequent_items_iter));
+				projected_support = database.project(depth, support, *frequent_items_iter);
+				if(projected_support == support) {
+					closed = false;
+				}
 				
-				if(std::distance(db_begin, end_iter) >= min_support) {
-					mine_patterns(db_begin, end_iter, seq, frequent_items, min_support, return_patterns);
+				if(projected_support >= min_support) {
+					if(spawn) {
+						task_type *task = create_task(tasks, database, depth + 1, projected_support, seq, frequent_items);
+						#pragma omp task firstprivate(task, min_support, sink)
+						mine_patterns(task->database, 0, task->database.size(), task->seq, task->items, min_support, task->patterns, *sink);
+					}
+					else {
+						mine_patterns(database, depth + 1, projected_support, seq, frequent_items, min_support, return_patterns, closed_patterns);
+					}
 					++frequent_items_iter;
 				}
 				else {
@@ -262,71 +168,112 @@ class projected_list_lazy_frequent_miner : public sequential_pattern_miner<Value
 					frequent_items.pop_back();
 				}
 				
-				tmp_iter = db_begin;
-				for(tmp_iter = db_begin; tmp_iter != end_iter; ++tmp_iter) {
-					tmp_iter->pop_projection();
-				}
-				
 				seq.pop_element();
 			}
+			
+			if(closed) {
+				write_closed(closed_patterns, seq, support);
+			}
+			
+			merge_tasks(tasks, return_patterns);
 		}
 		
-		void mine_patterns(typename std::vector<projected_sequence<Value2> >::iterator db_begin, typename std::vector<projected_sequence<Value2> >::iterator db_end, const std::vector<Value2> &items, unsigned int min_support, std::map<unsigned int,std::list<sequence<Value2> > > &return_patterns) const {
+		template <typename Database>
+		void mine_patterns(Database &database, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<Value2> &return_patterns, pattern_sink<Value2> &closed_patterns) const {
 			sequence<Value2> seq;
 			
-			typename std::vector<projected_sequence<Value2> >::iterator tmp_iter;
-			typename std::vector<projected_sequence<Value2> >::iterator end_iter;
+			typedef typename sequential_pattern_miner<Value1,Value2>::template projected_task<Database,Value2> task_type;
+			std::list<task_type> tasks;
+			unsigned int support = database.size();
+			bool spawn = spawn_tasks(support);
+			pattern_sink<Value2> *sink = &closed_patterns;
+			
+			unsigned int projected_support;
 			typename std::vector<Value2>::const_iterator items_iter = items.begin();
 			for(; items_iter != items.end(); ++items_iter) {
 				seq.push_element(*items_iter);
 				
-				end_iter = std::partition(db_begin, db_end, project_sequence<Value1,Value2>(*items_iter));
-				mine_patterns(db_begin, end_iter, seq, items, min_support, return_patterns);
-				
-				tmp_iter = db_begin;
-				for(tmp_iter = db_begin; tmp_iter != end_iter; ++tmp_iter) {
-					tmp_iter->pop_projection();
+				projected_support = database.project(0, support, *items_iter);
+				if(spawn) {
+					task_type *task = create_task(tasks, database, 1, projected_support, seq, items);
+					#pragma omp task firstprivate(task, min_support, sink)
+					mine_patterns(task->database, 0, task->database.size(), task->seq, task->items, min_support, task->patterns, *sink);
+				}
+				else {
+					mine_patterns(database, 1, projected_support, seq, items, min_support, return_patterns, closed_patterns);
 				}
 				
 				seq.pop_element();
 			}
+			
+			merge_tasks(tasks, return_patterns);
 		}
 		
-		void mine_patterns(typename std::vector<projected_sequence<ordered_set<Value2> > >::iterator db_begin, typename std::vector<projected_sequence<ordered_set<Value2> > >::iterator db_end, sequence<ordered_set<Value2> > &seq, const std::vector<Value2> &items, unsigned int min_support, std::map<unsigned int,std::list<sequence<ordered_set<Value2> > > > &return_patterns) const {
-			//std::cout << std::distance(db_begin, db_end) << " " << seq << std::endl;
-			maintain_and_test(seq, std::distance(db_begin, db_end), return_patterns);
+		template <typename Database>
+		void mine_patterns(Database &database, unsigned int depth, unsigned int support, sequence<ordered_set<Value2> > &seq, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<ordered_set<Value2> > &return_patterns, pattern_sink<ordered_set<Value2> > &closed_patterns) const {
+			//std::cout << support << " " << seq << std::endl;
+			maintain_and_test(seq, support, return_patterns);
 			
-			typename std::vector<projected_sequence<ordered_set<Value2> > >::iterator tmp_iter;
-			typename std::vector<projected_sequence<ordered_set<Value2> > >::iterator end_iter;
-			typename std::vector<Value2>::const_iterator items_iter = items.begin();
-			for(; items_iter != items.end(); ++items_iter) {
-				if(seq.push_item(*items_iter)) {
-					end_iter = std::partition(db_begin, db_end, project_item<Value1,Value2>(*items_iter));
-					
-					if(std::distance(db_begin, end_iter) >= min_support) {
-						mine_patterns(db_begin, end_iter, seq, items, min_support, return_patterns);
-					}
+			std::vector<Value2> set_items, frequent_items, local_items;
+			if(local_counting) {
+				count_local_items(database, depth, support, seq, items, min_support, set_items, frequent_items, local_items);
+			}
+			else {
+				frequent_items = items;
+			}
+			
+			const std::vector<Value2> &extension_items = local_counting ? set_items : items;
+			const std::vector<Value2> &child_items = local_counting ? local_items : items;
+			
+			typedef typename sequential_pattern_miner<Value1,Value2>::template projected_task<Database,ordered_set<Value2> > task_type;
+			std::list<task_type> tasks;
+			bool spawn = spawn_tasks(support);
+			pattern_sink<ordered_set<Value2> > *sink = &closed_patterns;
+			
+			unsigned int projected_support;
+			typename std::vector<Value2>::const_iterator items_iter = extension_items.begin();
+			for(; items_iter != extension_items.end(); ++items_iter) {
+				if(cooccurrences.set_extension(seq.last().get_element(), *items_iter) && seq.push_item(*items_iter)) {
+					projected_support = database.project_item(depth, support, *items_iter);
 					
-					tmp_iter = db_begin;
-					for(tmp_iter = db_begin; tmp_iter != end_iter; ++tmp_iter) {
-						tmp_iter->pop_projection();
+					if(projected_support >= min_support) {
+						if(spawn) {
+							task_type *task = create_task(tasks, database, depth + 1, projected_support, seq, child_items);
+							#pragma omp task firstprivate(task, min_support, sink)
+							mine_patterns(task->database, 0, task->database.size(), task->seq, task->items, min_support, task->patterns, *sink);
+						}
+						else {
+							mine_patterns(database, depth + 1, projected_support, seq, child_items, min_support, return_patterns, closed_patterns);
+						}
 					}
 					
 					seq.pop_item();
 				}
 			}
 			
-			std::vector<Value2> frequent_items(items);
-			
+			Value2 last_item = seq.last().get_element();
 			seq.push_element(ordered_set<Value2>());
 			typename std::vector<Value2>::iterator frequent_items_iter = frequent_items.begin();
 			while(frequent_items_iter != frequent_items.end()) {
+				if(!cooccurrences.sequence_extension(last_item, *frequent_items_iter)) {
+					std::swap(*frequent_items_iter, frequent_items.back());
+					frequent_items.pop_back();
+					continue;
+				}
+				
 				seq.push_item(*frequent_items_iter);
 				
-				end_iter = std::partition(db_begin, db_end, project_set<Value1,Value2>(*frequent_items_iter));
+				projected_support = database.project_set(depth, support, *frequent_items_iter);
 				
-				if(std::distance(db_begin, end_iter) >= min_support) {
-					mine_patterns(db_begin, end_iter, seq, frequent_items, min_support, return_patterns);
+				if(projected_support >= min_support) {
+					if(spawn) {
+						task_type *task = create_task(tasks, database, depth + 1, projected_support, seq, frequent_items);
+						#pragma omp task firstprivate(task, min_support, sink)
+						mine_patterns(task->database, 0, task->database.size(), task->seq, task->items, min_support, task->patterns, *sink);
+					}
+					else {
+						mine_patterns(database, depth + 1, projected_support, seq, frequent_items, min_support, return_patterns, closed_patterns);
+					}
 					++frequent_items_iter;
 				}
 				else {
@@ -334,38 +281,45 @@ class projected_list_lazy_frequent_miner : public sequential_pattern_miner<Value
 					frequent_items.pop_back();
 				}
 				
-				tmp_iter = db_begin;
-				for(tmp_iter = db_begin; tmp_iter != end_iter; ++tmp_iter) {
-					tmp_iter->pop_projection();
-				}
-				
 				seq.pop_item();
 			}
 			seq.pop_element();
+			
+			merge_tasks(tasks, return_patterns);
 		}
 		
-		void mine_patterns(typename std::vector<projected_sequence<ordered_set<Value2> > >::iterator db_begin, typename std::vector<projected_sequence<ordered_set<Value2> > >::iterator db_end, const std::vector<Value2> &items, unsigned int min_support, std::map<unsigned int,std::list<sequence<ordered_set<Value2> > > > &return_patterns) const {
+		template <typename Database>
+		void mine_patterns(Database &database, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<ordered_set<Value2> > &return_patterns, pattern_sink<ordered_set<Value2> > &closed_patterns) const {
 			sequence<ordered_set<Value2> > seq;
 			seq.push_element(ordered_set<Value2>());
 			
-			typename std::vector<projected_sequence<ordered_set<Value2> > >::iterator tmp_iter;
-			typename std::vector<projected_sequence<ordered_set<Value2> > >::iterator end_iter;
+			typedef typename sequential_pattern_miner<Value1,Value2>::template projected_task<Database,ordered_set<Value2> > task_type;
+			std::list<task_type> tasks;
+			unsigned int support = database.size();
+			bool spawn = spawn_tasks(support);
+			pattern_sink<ordered_set<Value2> > *sink = &closed_patterns;
+			
+			unsigned int projected_support;
 			typename std::vector<Value2>::const_iterator items_iter = items.begin();
 			for(; items_iter != items.end(); ++items_iter) {
 				seq.push_item(*items_iter);
 				
-				end_iter = std::partition(db_begin, db_end, project_set<Value1,Value2>(*items_iter));
-				
-				mine_patterns(db_begin, end_iter, seq, items, min_support, return_patterns);
+				projected_support = database.project_set(0, support, *items_iter);
 				
-				tmp_iter = db_begin;
-				for(tmp_iter = db_begin; tmp_iter != end_iter; ++tmp_iter) {
-					tmp_iter->pop_projection();
+				if(spawn) {
+					task_type *task = create_task(tasks, database, 1, projected_support, seq, items);
+					#pragma omp task firstprivate(task, min_support, sink)
+					mine_patterns(task->database, 0, task->database.size(), task->seq, task->items, min_support, task->patterns, *sink);
+				}
+				else {
+					mine_patterns(database, 1, projected_support, seq, items, min_support, return_patterns, closed_patterns);
 				}
 				
 				seq.pop_item();
 			}
 			seq.pop_element();
+			
+			merge_tasks(tasks, return_patterns);
 		}
 		
 };
@@ -1,5 +1,7 @@
 #include "ordered_set.hh"
 #include "sequence.hh"
+#include "sequence_parser.hh"
+#include "mapped_file.hh"
 
 #include <iostream>
 #include <fstream>
@@ -72,7 +74,7 @@ bool parse_args(int argc, char *argv[], bool &itemset, bool &numeric, string &oc
 					
 					return false;
 				}
-			
+				
 				occurrences.assign(argv[ii]);
 			}
 			else if(strcmp(argv[ii], "-s") == 0 || strcmp(argv[ii], "--support") == 0) {
@@ -83,7 +85,7 @@ bool parse_args(int argc, char *argv[], bool &itemset, bool &numeric, string &oc
 					
 					return false;
 				}
-			
+				
 				support.assign(argv[ii]);
 			}
 			else if(infile.empty()) {
@@ -112,25 +114,10 @@ bool parse_args(int argc, char *argv[], bool &itemset, bool &numeric, string &oc
 
 template <typename T>
 void load_database(const string &file_name, vector<sequence<T> > &database) {
-	ifstream file(file_name.c_str());
-	if(file) {
-		file >> database;
-		if(file.bad()) {
-			ostringstream oss;
-			oss <<  file_name << ": " << strerror(errno);
-			
-			throw runtime_error(oss.str());
-		}
-		else if(file.fail() && !file.eof()) {
-			ostringstream oss;
-			oss <<  file_name << ": error reading file";
-			
-			throw runtime_error(oss.str());
-		}
-	}
-	else {
+	mapped_file file(file_name);
+	if(!parse_database(file.begin(), file.end(), database)) {
 		ostringstream oss;
-		oss <<  file_name << ": " << strerror(errno);
+		oss <<  file_name << ": error reading file";
 		
 		throw runtime_error(oss.str());
 	}
@@ -308,6 +295,6 @@ int main(int argc, char *argv[]) {
 	catch(exception &e) {
 		cerr << e.what() << endl;
 	}
-			
+	
 	return 0;
 }
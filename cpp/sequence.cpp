@@ -1,5 +1,7 @@
 #include "ordered_set.hh"
 #include "sequence.hh"
+#include "sequence_parser.hh"
+#include "mapped_file.hh"
 
 #include <iostream>
 #include <fstream>
@@ -82,25 +84,10 @@ bool parse_args(int argc, char *argv[], bool &itemset, bool &numeric, vector<str
 
 template <typename T>
 void load_database(const string &file_name, vector<sequence<T> > &database) {
-	ifstream file(file_name.c_str());
-	if(file) {
-		file >> database;
-		if(file.bad()) {
-			ostringstream oss;
-			oss <<  file_name << ": " << strerror(errno);
-			
-			throw runtime_error(oss.str());
-		}
-		else if(file.fail() && !file.eof()) {
-			ostringstream oss;
-			oss <<  file_name << ": error reading file";
-			
-			throw runtime_error(oss.str());
-		}
-	}
-	else {
+	mapped_file file(file_name);
+	if(!parse_database(file.begin(), file.end(), database)) {
 		ostringstream oss;
-		oss <<  file_name << ": " << strerror(errno);
+		oss <<  file_name << ": error reading file";
 		
 		throw runtime_error(oss.str());
 	}
@@ -290,7 +277,7 @@ void display_stats(const string &file_name) {
 template <typename T>
 void display_stats(const string &file_name, vector<sequence<T> > &database) {
 	cout << setw(9) << database.size() << "  "; cout.flush();
-		
+	
 	std::sort(database.begin(), database.end());
 	unsigned int unique = database.size();
 	for(unsigned int ii=1; ii < database.size(); ii++) {
@@ -425,6 +412,6 @@ int main(int argc, char *argv[]) {
 	catch(exception &e) {
 		cerr << e.what() << endl;
 	}
-			
+	
 	return 0;
 }
@@ -25,6 +25,7 @@
 
 #include "infix_iterator.hh"
 #include "ordered_set.hh"
+#include "position_index.hh"
 
 template <typename T>
 class sequence {
@@ -206,7 +207,8 @@ class sequence {
 			seq.insert(seq.end(), other.begin(), other.end());
 		}
 		
-		bool subsequence(const sequence &that) const {
+		template <typename Sequence>
+		bool subsequence(const Sequence &that) const {
 			/*const_iterator this_iter = begin();
 			const_iterator that_iter = that.begin();
 			while(this_iter != end()) {
@@ -230,7 +232,7 @@ class sequence {
 			return true;*/
 			
 			const_iterator this_iter = begin();
-			const_iterator that_iter = that.begin();
+			typename Sequence::const_iterator that_iter = that.begin();
 			while(this_iter != end() && that_iter != that.end()) {
 				if(*this_iter == *that_iter) {
 					++this_iter;
@@ -242,6 +244,24 @@ class sequence {
 			return this_iter == end();
 		}
 		
+		/* the same test against a sequence through its position index, jumping
+		 * to the next occurrence of every item instead of scanning for it */
+		bool subsequence(const position_index<T> &index) const {
+			unsigned int position = 0;
+			
+			const_iterator this_iter = begin();
+			for(; this_iter != end(); ++this_iter) {
+				position = index.next(*this_iter, position);
+				if(position == position_index<T>::npos) {
+					return false;
+				}
+				
+				position++;
+			}
+			
+			return true;
+		}
+		
 		virtual void swap(sequence &other) {
 			seq.swap(other.seq);
 		}
@@ -635,7 +655,8 @@ class sequence<ordered_set<T> > {
 			seq.insert(seq.end(), other.begin(), other.end());
 		}
 		
-		bool subsequence(const sequence &that) const {
+		template <typename Sequence>
+		bool subsequence(const Sequence &that) const {
 			/*const_iterator this_iter = begin();
 			const_iterator that_iter = that.begin();
 			while(this_iter != end()) {
@@ -659,7 +680,7 @@ class sequence<ordered_set<T> > {
 			return true;*/
 			
 			const_iterator this_iter = begin();
-			const_iterator that_iter = that.begin();
+			typename Sequence::const_iterator that_iter = that.begin();
 			while(this_iter != end() && that_iter != that.end()) {
 				if(this_iter->subset(*that_iter)) {
 					++this_iter;
@@ -671,6 +692,24 @@ class sequence<ordered_set<T> > {
 			return this_iter == end();
 		}
 		
+		/* the same test against a sequence through its position index, jumping
+		 * to the next element holding every item instead of scanning for it */
+		bool subsequence(const position_index<ordered_set<T> > &index) const {
+			unsigned int position = 0;
+			
+			const_iterator this_iter = begin();
+			for(; this_iter != end(); ++this_iter) {
+				position = index.next_element(*this_iter, position);
+				if(position == position_index<T>::npos) {
+					return false;
+				}
+				
+				position++;
+			}
+			
+			return true;
+		}
+		
 		virtual void swap(sequence &other) {
 			seq.swap(other.seq);
 		}
@@ -823,7 +862,8 @@ struct is_subsequence {
 	
 	}
 	
-	bool operator()(const sequence<T> *test_seq) const {
+	template <typename Sequence>
+	bool operator()(const Sequence *test_seq) const {
 		return seq.subsequence(*test_seq);
 	}
 };
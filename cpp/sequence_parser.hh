@@ -0,0 +1,418 @@
+#ifndef _SEQUENCE_PARSER_HH_
+#define _SEQUENCE_PARSER_HH_
+
+#include <istream>
+#include <sstream>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <algorithm>
+#include <limits>
+
+#include <cstddef>
+#include <cstring>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "ordered_set.hh"
+#include "sequence.hh"
+#include "binary_database.hh"
+
+/* parser for the <a,b,(c,d)> text format working directly on a byte buffer
+ *
+ * accepts the same grammar as sequence<T>::deserialize: whitespace is skipped
+ * around delimiters and numeric items, string items run up to the next
+ * delimiter, and a labeled sequence is followed by a 0 or 1 label. integer
+ * items are converted in place, other item types go through a string stream. */
+class sequence_parser {
+	public:
+		sequence_parser(const char *begin, const char *end) : position(begin), end(end), failed(false) {
+			
+		}
+		
+		/* reads the next sequence, returns false at the end of the input or on a
+		 * malformed sequence, in which case fail() is set */
+		template <typename T>
+		bool parse(sequence<T> &seq) {
+			seq.clear();
+			
+			if(!start_sequence()) {
+				return false;
+			}
+			
+			char delim = 0;
+			while(delim != '>') {
+				T item;
+				if(!parse_item(item, '>') || !parse_delimiter('>', delim)) {
+					failed = true;
+					return false;
+				}
+				
+				seq.push_element(item);
+			}
+			
+			return true;
+		}
+		
+		template <typename T>
+		bool parse(sequence<ordered_set<T> > &seq) {
+			seq.clear();
+			
+			if(!start_sequence()) {
+				return false;
+			}
+			
+			std::vector<T> items;
+			
+			char delim = 0;
+			while(delim != '>') {
+				skip_space();
+				if(position == end || *position != '(') {
+					failed = true;
+					return false;
+				}
+				++position;
+				
+				items.clear();
+				
+				char set_delim = 0;
+				while(set_delim != ')') {
+					T item;
+					if(!parse_item(item, ')') || !parse_delimiter(')', set_delim)) {
+						failed = true;
+						return false;
+					}
+					
+					items.push_back(item);
+				}
+				
+				std::sort(items.begin(), items.end());
+				items.erase(std::unique(items.begin(), items.end()), items.end());
+				
+				seq.push_element(ordered_set<T>());
+				typename std::vector<T>::const_iterator items_iter = items.begin();
+				for(; items_iter != items.end(); ++items_iter) {
+					seq.push_item(*items_iter);
+				}
+				
+				if(!parse_delimiter('>', delim)) {
+					failed = true;
+					return false;
+				}
+			}
+			
+			return true;
+		}
+		
+		template <typename T>
+		bool parse(std::pair<bool,sequence<T> > &labeled_seq) {
+			if(!parse(labeled_seq.second)) {
+				return false;
+			}
+			
+			int label;
+			if(!parse_integer(label) || (label != 0 && label != 1)) {
+				failed = true;
+				return false;
+			}
+			
+			labeled_seq.first = (label == 1);
+			
+			return true;
+		}
+		
+		bool fail() const {
+			return failed;
+		}
+		
+	private:
+		const char *position;
+		const char *end;
+		bool failed;
+		
+		static bool is_space(char c) {
+			return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+		}
+		
+		void skip_space() {
+			while(position != end && is_space(*position)) {
+				++position;
+			}
+		}
+		
+		/* consumes the opening '<', false at the end of the input */
+		bool start_sequence() {
+			skip_space();
+			if(position == end) {
+				return false;
+			}
+			else if(*position != '<') {
+				failed = true;
+				return false;
+			}
+			
+			++position;
+			return true;
+		}
+		
+		/* reads ',' or close into delim */
+		bool parse_delimiter(char close, char &delim) {
+			skip_space();
+			if(position == end || (*position != ',' && *position != close)) {
+				return false;
+			}
+			
+			delim = *position++;
+			return true;
+		}
+		
+		template <typename T>
+		bool parse_integer(T &value) {
+			skip_space();
+			
+			bool negative = false;
+			if(position != end && (*position == '-' || *position == '+')) {
+				negative = (*position == '-');
+				++position;
+			}
+			
+			if(position == end || *position < '0' || *position > '9') {
+				return false;
+			}
+			
+			unsigned long limit = std::numeric_limits<T>::max();
+			if(negative) {
+				limit = std::numeric_limits<T>::is_signed ? limit + 1 : 0;
+			}
+			
+			unsigned long magnitude = 0;
+			for(; position != end && *position >= '0' && *position <= '9'; ++position) {
+				unsigned long digit = *position - '0';
+				if(magnitude > (limit - digit) / 10) {
+					return false;
+				}
+				magnitude = magnitude * 10 + digit;
+			}
+			
+			if(negative && magnitude > 0) {
+				value = -(T)(magnitude - 1) - 1;
+			}
+			else {
+				value = (T)magnitude;
+			}
+			
+			return true;
+		}
+		
+		bool parse_item(int &item, char) {
+			return parse_integer(item);
+		}
+		
+		bool parse_item(long &item, char) {
+			return parse_integer(item);
+		}
+		
+		bool parse_item(unsigned int &item, char) {
+			return parse_integer(item);
+		}
+		
+		bool parse_item(unsigned long &item, char) {
+			return parse_integer(item);
+		}
+		
+		/* string items are everything up to the next delimiter, as in deserialize */
+		bool parse_item(std::string &item, char close) {
+			const char *item_begin = position;
+			while(position != end && *position != ',' && *position != close) {
+				++position;
+			}
+			
+			if(position == end) {
+				return false;
+			}
+			
+			item.assign(item_begin, position);
+			return true;
+		}
+		
+		template <typename T>
+		bool parse_item(T &item, char close) {
+			skip_space();
+			
+			const char *item_begin = position;
+			while(position != end && *position != ',' && *position != close && !is_space(*position)) {
+				++position;
+			}
+			
+			std::istringstream iss(std::string(item_begin, position));
+			iss >> item;
+			
+			return !iss.fail() && iss.peek() == std::char_traits<char>::eof();
+		}
+};
+
+/* appends the sequences in [begin, end) to container, false on malformed input */
+template <template <typename, typename> class Container, typename Value, typename Allocator>
+bool parse_sequences(const char *begin, const char *end, Container<sequence<Value>, Allocator> &container) {
+	sequence_parser parser(begin, end);
+	
+	sequence<Value> seq;
+	while(parser.parse(seq)) {
+		container.insert(container.end(), sequence<Value>());
+		container.back().swap(seq);
+	}
+	
+	return !parser.fail();
+}
+
+template <template <typename, typename> class Container, typename Value, typename Allocator>
+bool parse_sequences(const char *begin, const char *end, Container<std::pair<bool,sequence<Value> >, Allocator> &container) {
+	sequence_parser parser(begin, end);
+	
+	std::pair<bool,sequence<Value> > labeled_seq;
+	while(parser.parse(labeled_seq)) {
+		container.insert(container.end(), std::pair<bool,sequence<Value> >(labeled_seq.first, sequence<Value>()));
+		container.back().second.swap(labeled_seq.second);
+	}
+	
+	return !parser.fail();
+}
+
+template <typename T>
+void swap_sequences(sequence<T> &lhs, sequence<T> &rhs) {
+	lhs.swap(rhs);
+}
+
+template <typename T>
+void swap_sequences(std::pair<bool,sequence<T> > &lhs, std::pair<bool,sequence<T> > &rhs) {
+	std::swap(lhs.first, rhs.first);
+	lhs.second.swap(rhs.second);
+}
+
+template <typename Container>
+void reserve_sequences(Container &, std::size_t) {
+	
+}
+
+template <typename T, typename Allocator>
+void reserve_sequences(std::vector<T, Allocator> &container, std::size_t size) {
+	container.reserve(size);
+}
+
+/* start of the first line at or after position that begins a sequence */
+inline const char * next_sequence(const char *position, const char *end) {
+	while(position != end) {
+		const char *newline = static_cast<const char *>(std::memchr(position, '\n', end - position));
+		if(newline == NULL || newline+1 == end) {
+			return end;
+		}
+		else if(newline[1] == '<') {
+			return newline+1;
+		}
+		
+		position = newline+1;
+	}
+	
+	return end;
+}
+
+/* inputs smaller than this are parsed on a single thread */
+static const std::size_t parallel_parse_size = 1 << 20;
+
+/* parses [begin, end) into container. with several OpenMP threads the input is
+ * split into chunks at lines starting a sequence, each chunk is parsed into its
+ * own container, and the chunks are moved into container in input order */
+template <typename Container>
+bool parse_chunks(const char *begin, const char *end, Container &container) {
+	#ifdef _OPENMP
+	unsigned int threads = omp_get_max_threads();
+	if(threads > 1 && (std::size_t) (end - begin) >= parallel_parse_size) {
+		unsigned int chunks = 4 * threads;
+		
+		std::vector<const char *> bounds(1, begin);
+		for(unsigned int ii=1; ii < chunks; ii++) {
+			const char *position = begin + (end - begin) / chunks * ii;
+			bounds.push_back(next_sequence(std::max(position-1, bounds.back()), end));
+		}
+		bounds.push_back(end);
+		
+		std::vector<Container> parts(chunks);
+		std::vector<char> parsed(chunks);
+		
+		#pragma omp parallel for schedule(dynamic)
+		for(int ii=0; ii < (int) chunks; ii++) {
+			parsed[ii] = parse_sequences(bounds[ii], bounds[ii+1], parts[ii]);
+		}
+		
+		std::size_t size = 0;
+		for(unsigned int ii=0; ii < chunks; ii++) {
+			if(!parsed[ii]) {
+				return false;
+			}
+			size += parts[ii].size();
+		}
+		
+		reserve_sequences(container, container.size() + size);
+		for(unsigned int ii=0; ii < chunks; ii++) {
+			typename Container::iterator parts_iter = parts[ii].begin();
+			for(; parts_iter != parts[ii].end(); ++parts_iter) {
+				container.insert(container.end(), typename Container::value_type());
+				swap_sequences(container.back(), *parts_iter);
+			}
+			
+			Container().swap(parts[ii]);
+		}
+		
+		return true;
+	}
+	#endif
+	
+	return parse_sequences(begin, end, container);
+}
+
+/* parses every sequence in the buffer into container, which is left unchanged
+ * when the buffer is malformed. buffers holding a binary database are decoded */
+template <typename Container>
+bool parse_database(const char *begin, const char *end, Container &container) {
+	if(is_binary_database(begin, end)) {
+		return read_binary_database(begin, end, container);
+	}
+	
+	Container tmp_container;
+	if(!parse_chunks(begin, end, tmp_container)) {
+		return false;
+	}
+	
+	container.swap(tmp_container);
+	return true;
+}
+
+template <typename Container>
+bool parse_database(const std::vector<char> &buffer, Container &container) {
+	if(buffer.empty()) {
+		return parse_database((const char *) NULL, (const char *) NULL, container);
+	}
+	
+	return parse_database(&buffer[0], &buffer[0] + buffer.size(), container);
+}
+
+/* reads the rest of input into buffer */
+inline void read_buffer(std::istream &input, std::vector<char> &buffer) {
+	std::vector<char>::size_type size = 0;
+	
+	buffer.resize(1 << 16);
+	while(input.read(&buffer[size], buffer.size() - size), input.gcount() > 0) {
+		size += input.gcount();
+		if(size == buffer.size()) {
+			buffer.resize(2 * size);
+		}
+	}
+	
+	buffer.resize(size);
+}
+
+#endif
@@ -14,11 +14,18 @@
 
 #include <cmath>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "timer.hh"
 #include "ordered_set.hh"
 #include "sequence.hh"
+#include "flat_database.hh"
 
+#include "cooccurrence_map.hh"
 #include "maintain_and_test.hh"
+#include "pattern_sink.hh"
 
 template <typename Iter, typename Test>
 Iter project_database(Iter first, Iter last, Test pred, unsigned int min_support) {
@@ -47,9 +54,191 @@ Iter project_database(Iter first, Iter last, Test pred, unsigned int min_support
 	return first;
 }
 
+/* position of item in the sorted item list, or items.size() when it is not listed */
+template <typename Value>
+unsigned int item_index(const std::vector<Value> &items, const Value &item) {
+	typename std::vector<Value>::const_iterator items_iter = std::lower_bound(items.begin(), items.end(), item);
+	if(items_iter == items.end() || item < *items_iter) {
+		return items.size();
+	}
+	
+	return std::distance(items.begin(), items_iter);
+}
+
+/* counts in how many sequences each candidate item occurs, in a dense array
+ * indexed by the position of the item among the sorted candidates */
+template <typename Value>
+class local_item_counter {
+	public:
+		local_item_counter(const std::vector<Value> &candidates) : items(candidates), counts(candidates.size(), 0), seen(candidates.size(), 0), sequence_count(0) {
+			std::sort(items.begin(), items.end());
+		}
+		
+		/* items added from here on belong to the next sequence */
+		void next_sequence() {
+			sequence_count++;
+		}
+		
+		void add(const Value &item) {
+			unsigned int index = item_index(items, item);
+			if(index < items.size() && seen[index] != sequence_count) {
+				seen[index] = sequence_count;
+				counts[index]++;
+			}
+		}
+		
+		template <typename Iter>
+		void add(Iter first, Iter last) {
+			for(; first != last; ++first) {
+				add(*first);
+			}
+		}
+		
+		bool frequent(const Value &item, unsigned int min_support) const {
+			unsigned int index = item_index(items, item);
+			return index < items.size() && counts[index] >= min_support;
+		}
+		
+	private:
+		std::vector<Value> items;
+		std::vector<unsigned int> counts;
+		std::vector<unsigned int> seen;
+		unsigned int sequence_count;
+};
+
+/* the candidates counted in at least min_support sequences, in their original order */
+template <typename Value>
+void local_frequent_items(const std::vector<Value> &candidates, const local_item_counter<Value> &counter, unsigned int min_support, std::vector<Value> &frequent_items) {
+	frequent_items.clear();
+	
+	typename std::vector<Value>::const_iterator candidates_iter = candidates.begin();
+	for(; candidates_iter != candidates.end(); ++candidates_iter) {
+		if(counter.frequent(*candidates_iter, min_support)) {
+			frequent_items.push_back(*candidates_iter);
+		}
+	}
+}
+
+/* counts the items that follow the leftmost embedding of pattern in seq, the
+ * only items that can extend the pattern within seq */
+template <typename Sequence, typename Value>
+void count_extensions(const Sequence &seq, const sequence<Value> &pattern, local_item_counter<Value> &counter) {
+	typename sequence<Value>::const_iterator pattern_iter = pattern.begin();
+	typename Sequence::const_iterator seq_iter = seq.begin();
+	for(; pattern_iter != pattern.end() && seq_iter != seq.end(); ++seq_iter) {
+		if(*pattern_iter == *seq_iter) {
+			++pattern_iter;
+		}
+	}
+	
+	counter.next_sequence();
+	counter.add(seq_iter, seq.end());
+}
+
+/* for itemsets, set_counter gets the items of the elements holding the last
+ * pattern element after the leftmost embedding of the rest of the pattern (the
+ * candidates to grow the last element), sequence_counter the items after the
+ * leftmost embedding of the whole pattern (the candidates for a new element) */
+template <typename Sequence, typename Value>
+void count_extensions(const Sequence &seq, const sequence<ordered_set<Value> > &pattern, local_item_counter<Value> &set_counter, local_item_counter<Value> &sequence_counter) {
+	typename sequence<ordered_set<Value> >::const_iterator last_element = pattern.end();
+	--last_element;
+	
+	typename sequence<ordered_set<Value> >::const_iterator pattern_iter = pattern.begin();
+	typename Sequence::const_iterator seq_iter = seq.begin();
+	for(; pattern_iter != last_element && seq_iter != seq.end(); ++seq_iter) {
+		if(pattern_iter->subset(*seq_iter)) {
+			++pattern_iter;
+		}
+	}
+	
+	set_counter.next_sequence();
+	sequence_counter.next_sequence();
+	if(pattern_iter != last_element) {
+		return;
+	}
+	
+	bool embedded = false;
+	for(; seq_iter != seq.end(); ++seq_iter) {
+		if(embedded) {
+			sequence_counter.add(seq_iter->begin(), seq_iter->end());
+		}
+		
+		if(last_element->subset(*seq_iter)) {
+			set_counter.add(seq_iter->begin(), seq_iter->end());
+			embedded = true;
+		}
+	}
+}
+
 template <typename Value1, typename Value2>
 class sequential_pattern_miner {
 	public:
+		sequential_pattern_miner() : task_threshold(0), closed_only(false), local_counting(false), cooccurrence_pruning(false), position_indexing(false), cooccurrences() {
+			
+		}
+		
+		/* prune non-closed branches during the search instead of filtering the
+		 * patterns afterwards, for miners that support it */
+		void set_closed_only(bool value) {
+			if(value && !supports_closed_only()) {
+				throw std::runtime_error("invalid option: closed-only mining is not supported by this miner");
+			}
+			
+			closed_only = value;
+		}
+		
+		/* recount the candidate items inside every projected database and pass
+		 * only the locally frequent ones on, for miners that support it */
+		void set_local_counting(bool value) {
+			if(value && !supports_local_counting()) {
+				throw std::runtime_error("invalid option: local counting is not supported by this miner");
+			}
+			
+			local_counting = value;
+		}
+		
+		/* skip extensions whose last item pair is infrequent, looked up in a
+		 * co-occurrence map built before mining, for miners that support it */
+		void set_cooccurrence_pruning(bool value) {
+			if(value && !supports_cooccurrence_pruning()) {
+				throw std::runtime_error("invalid option: co-occurrence pruning is not supported by this miner");
+			}
+			
+			cooccurrence_pruning = value;
+		}
+		
+		/* index the positions of every item in each sequence and project by
+		 * binary search, for miners that support it */
+		void set_position_indexing(bool value) {
+			if(value && !supports_position_indexing()) {
+				throw std::runtime_error("invalid option: position indexing is not supported by this miner");
+			}
+			
+			position_indexing = value;
+		}
+		
+		virtual bool supports_closed_only() const {
+			return false;
+		}
+		
+		virtual bool supports_local_counting() const {
+			return false;
+		}
+		
+		virtual bool supports_cooccurrence_pruning() const {
+			return true;
+		}
+		
+		virtual bool supports_position_indexing() const {
+			return false;
+		}
+		
+		/* whether the search spawns subtrees as tasks when run with several threads */
+		virtual bool supports_threads() const {
+			return true;
+		}
+		
 		#ifndef NDEBUG
 		mutable std::vector<std::vector<std::string> > graph;
 		
@@ -71,7 +260,7 @@ class sequential_pattern_miner {
 			oss << items.size() << " = {";
 			typename std::vector<Value2>::const_iterator items_iter = items.begin();
 			while(items_iter != items.end()) {
-			
+				
 				oss << *items_iter;
 				if(++items_iter != items.end()) {
 					oss << ",";
@@ -92,7 +281,7 @@ class sequential_pattern_miner {
 		void write_graph(const std::string &output_graph_name) {
 			std::string output_graph_name(database_file);
 			output_graph_name += ".gv";
-		
+			
 			std::ofstream output_graph_file(output_graph_name.c_str());
 			if(output_graph_file) {
 				output_graph_file << "digraph G {" << std::endl;
@@ -120,8 +309,11 @@ class sequential_pattern_miner {
 		
 		#endif
 		
-		template <template <typename, typename> class Container, typename Alloc>
-		void mine(const Container<sequence<Value1>, Alloc> &database, double relative_support, bool strip_sequences, std::map<unsigned int,std::list<sequence<Value1> > > &return_patterns) const {
+		/* return_patterns is either a std::map<unsigned int,std::list<sequence<Value1> > >
+		 * filled with the patterns of each support, or a pattern_sink<Value1> the
+		 * patterns are streamed to */
+		template <typename Database, typename Patterns>
+		void mine(const Database &database, double relative_support, bool strip_sequences, Patterns &return_patterns) const {
 			if(relative_support < 0.0 || relative_support > 1.0) {
 				std::ostringstream oss;
 				oss << "domain error: invalid support (" << relative_support << "): support must be between 0.0 and 1.0";
@@ -131,8 +323,8 @@ class sequential_pattern_miner {
 			mine(database, (unsigned int) ceil(database.size() * relative_support), strip_sequences, return_patterns);
 		}
 		
-		template <template <typename, typename> class Container, typename Alloc>
-		void mine(const Container<sequence<Value1>, Alloc> &database, unsigned int absolute_support, bool strip_sequences, std::map<unsigned int,std::list<sequence<Value1> > > &return_patterns) const {
+		template <typename Database, typename Patterns>
+		void mine(const Database &database, unsigned int absolute_support, bool strip_sequences, Patterns &return_patterns) const {
 			std::set<Value2> itemset;
 			
 			std::cout << "Extract Items: ";
@@ -148,13 +340,13 @@ class sequential_pattern_miner {
 			mine(database, itemset, absolute_support, strip_sequences, return_patterns);
 		}
 		
-		template <template <typename, typename> class Container, typename Alloc>
-		void mine(const Container<sequence<Value1>, Alloc> &database, const std::set<Value2> &items, double relative_support, bool strip_sequences, std::map<unsigned int,std::list<sequence<Value1> > > &return_patterns) const {
+		template <typename Database, typename Patterns>
+		void mine(const Database &database, const std::set<Value2> &items, double relative_support, bool strip_sequences, Patterns &return_patterns) const {
 			mine(database, items, (unsigned int) ceil(database.size() * relative_support), strip_sequences, return_patterns);
 		}
 		
-		template <template <typename, typename> class Container, typename Alloc>
-		void mine(const Container<sequence<Value1>, Alloc> &database, const std::set<Value2> &items, unsigned int absolute_support, bool strip_sequences, std::map<unsigned int,std::list<sequence<Value1> > > &return_patterns) const {
+		template <typename Database, typename Patterns>
+		void mine(const Database &database, const std::set<Value2> &items, unsigned int absolute_support, bool strip_sequences, Patterns &return_patterns) const {
 			std::vector<Value2> frequent_items;
 			
 			std::cout << "Extract Frequent Items: ";
@@ -244,9 +436,225 @@ class sequential_pattern_miner {
 			}
 		}
 		
+		template <typename Value>
+		void extract_items(const flat_database<Value> &database, std::set<Value> &itemset) const {
+			for(typename flat_database<Value>::size_type ii=0; ii < database.size(); ii++) {
+				sequence_view<Value> seq = database[ii];
+				itemset.insert(seq.begin(), seq.end());
+			}
+		}
+		
+		template <typename Value>
+		void extract_items(const flat_database<ordered_set<Value> > &database, std::set<Value> &itemset) const {
+			for(typename flat_database<ordered_set<Value> >::size_type ii=0; ii < database.size(); ii++) {
+				sequence_view<ordered_set<Value> > seq = database[ii];
+				
+				typename sequence_view<ordered_set<Value> >::const_iterator seq_iter = seq.begin();
+				for(; seq_iter != seq.end(); ++seq_iter) {
+					itemset.insert(seq_iter->begin(), seq_iter->end());
+				}
+			}
+		}
+		
+		void extract_frequent_items(const flat_database<Value2> &database, const std::set<Value2> &items, unsigned int min_support, std::vector<Value2> &frequent_items) const {
+			std::map<Value2,unsigned int> counts;
+			
+			for(typename flat_database<Value2>::size_type ii=0; ii < database.size(); ii++) {
+				sequence_view<Value2> seq = database[ii];
+				std::set<Value2> seq_items(seq.begin(), seq.end());
+				
+				typename std::set<Value2>::iterator seq_items_iter = seq_items.begin();
+				for(; seq_items_iter != seq_items.end(); ++seq_items_iter) {
+					counts[*seq_items_iter]++;
+				}
+			}
+			
+			frequent_items.reserve(items.size());
+			typename std::set<Value2>::const_iterator items_iter = items.begin();
+			for(; items_iter != items.end(); ++items_iter) {
+				if(counts[*items_iter] >= min_support) {
+					frequent_items.push_back(*items_iter);
+				}
+			}
+		}
+		
+		void extract_frequent_items(const flat_database<ordered_set<Value2> > &database, const std::set<Value2> &items, unsigned int min_support, std::vector<Value2> &frequent_items) const {
+			std::map<Value2,unsigned int> counts;
+			
+			for(typename flat_database<ordered_set<Value2> >::size_type ii=0; ii < database.size(); ii++) {
+				std::set<Value2> seq_items;
+				
+				sequence_view<ordered_set<Value2> > tmp_seq = database[ii];
+				
+				typename sequence_view<ordered_set<Value2> >::const_iterator tmp_seq_iter = tmp_seq.begin();
+				for(; tmp_seq_iter != tmp_seq.end(); ++tmp_seq_iter) {
+					seq_items.insert(tmp_seq_iter->begin(), tmp_seq_iter->end());
+				}
+				
+				typename std::set<Value2>::iterator seq_items_iter = seq_items.begin();
+				for(; seq_items_iter != seq_items.end(); ++seq_items_iter) {
+					counts[*seq_items_iter]++;
+				}
+			}
+			
+			frequent_items.reserve(items.size());
+			typename std::set<Value2>::const_iterator items_iter = items.begin();
+			for(; items_iter != items.end(); ++items_iter) {
+				if(counts[*items_iter] >= min_support) {
+					frequent_items.push_back(*items_iter);
+				}
+			}
+		}
+		
 	protected:
 		mutable timer<long double> time;
 		
+		/* nodes whose projected database holds at least this many sequences mine
+		 * each child as a separate task, zero when mining with a single thread */
+		mutable unsigned int task_threshold;
+		
+		bool closed_only;
+		bool local_counting;
+		bool cooccurrence_pruning;
+		bool position_indexing;
+		
+		/* frequent item pairs of the database being mined, empty unless
+		 * cooccurrence_pruning is set */
+		mutable cooccurrence_map<Value2> cooccurrences;
+		
+		/* a subtree mined as a task, with its own slice of the projected database
+		 * and its own patterns, merged into the parent once the task completes */
+		template <typename Iter, typename T>
+		struct mining_task {
+			std::vector<typename std::iterator_traits<Iter>::value_type> database;
+			sequence<T> seq;
+			std::vector<Value2> items;
+			closed_pattern_store<T> patterns;
+		};
+		
+		/* the same for miners over a projected_database, the task holding a copy
+		 * of the sequences supporting its pattern as projected so far */
+		template <typename Database, typename T>
+		struct projected_task {
+			Database database;
+			sequence<T> seq;
+			std::vector<Value2> items;
+			closed_pattern_store<T> patterns;
+		};
+		
+		/* miners without tasks search on one thread, more threads then only
+		 * speed up reading the database */
+		void start_tasks(unsigned int database_size) const {
+			task_threshold = 0;
+			
+			#ifdef _OPENMP
+			unsigned int threads = omp_get_max_threads();
+			if(threads > 1 && supports_threads()) {
+				task_threshold = std::max(1u, database_size / (8 * threads));
+			}
+			#endif
+		}
+		
+		template <typename Iter>
+		bool spawn_tasks(Iter db_begin, Iter db_end) const {
+			return spawn_tasks((unsigned int) std::distance(db_begin, db_end));
+		}
+		
+		bool spawn_tasks(unsigned int database_size) const {
+			return task_threshold > 0 && database_size >= task_threshold;
+		}
+		
+		template <typename Task, typename Iter, typename Sequence>
+		Task * create_task(std::list<Task> &tasks, Iter db_begin, Iter db_end, const Sequence &seq, const std::vector<Value2> &items) const {
+			tasks.push_back(Task());
+			
+			Task &task = tasks.back();
+			task.database.assign(db_begin, db_end);
+			task.seq = seq;
+			task.items = items;
+			
+			return &task;
+		}
+		
+		template <typename Task, typename Database, typename Sequence>
+		Task * create_task(std::list<Task> &tasks, const Database &database, unsigned int depth, unsigned int support, const Sequence &seq, const std::vector<Value2> &items) const {
+			tasks.push_back(Task());
+			
+			Task &task = tasks.back();
+			task.database.assign(database, depth, support);
+			task.seq = seq;
+			task.items = items;
+			
+			return &task;
+		}
+		
+		/* waits for the tasks spawned by the current node and merges their patterns in
+		 * spawn order, giving the same patterns in the same order as a sequential run */
+		template <typename Task, typename T>
+		void merge_tasks(std::list<Task> &tasks, closed_pattern_store<T> &return_patterns) const {
+			#pragma omp taskwait
+			
+			typename std::list<Task>::iterator tasks_iter = tasks.begin();
+			for(; tasks_iter != tasks.end(); ++tasks_iter) {
+				return_patterns.merge(tasks_iter->patterns);
+			}
+		}
+		
+		template <typename Sequence>
+		void build_cooccurrences(const std::vector<const Sequence *> &database, const std::vector<Value2> &frequent_items, unsigned int min_support) const {
+			cooccurrences.clear();
+			if(!cooccurrence_pruning) {
+				return;
+			}
+			
+			std::cout << "Co-occurrence Map: ";
+			std::cout.flush();
+			
+			time.tic();
+			cooccurrences.build(database.begin(), database.end(), frequent_items, min_support);
+			std::cerr << time.toc() << ",";
+			std::cerr.flush();
+			
+			std::cout << std::endl;
+		}
+		
+		/* closed-only searches write their patterns as they find them, one task at a time */
+		template <typename T>
+		void write_closed(pattern_sink<T> &closed_patterns, const sequence<T> &seq, unsigned int support) const {
+			#pragma omp critical(closed_patterns)
+			closed_patterns.write(seq, support);
+		}
+		
+		template <typename Sequence>
+		void search(std::vector<const Sequence *> &database, const std::vector<Value2> &frequent_items, unsigned int min_support, std::map<unsigned int,std::list<sequence<Value1> > > &return_patterns) const {
+			pattern_map_sink<Value1> sink(return_patterns);
+			search(database, frequent_items, min_support, sink);
+		}
+		
+		/* maintain_and_test collects the patterns in a store that is written out,
+		 * support by support, once mining is done. closed-only searches bypass the
+		 * store and write to sink directly */
+		template <typename Sequence>
+		void search(std::vector<const Sequence *> &database, const std::vector<Value2> &frequent_items, unsigned int min_support, pattern_sink<Value1> &sink) const {
+			std::cout << "Mining: ";
+			std::cout.flush();
+			
+			time.tic();
+			closed_pattern_store<Value1> patterns;
+			start_tasks(database.size());
+			#pragma omp parallel if(task_threshold > 0)
+			{
+				#pragma omp single
+				mine_patterns(database, frequent_items, min_support, patterns, sink);
+			}
+			std::cerr << time.toc() << ",";
+			std::cerr.flush();
+			
+			std::cout << std::endl;
+			
+			patterns.drain(sink);
+		}
+		
 		struct get_pointer {
 			template <typename T>
 			T * operator()(T &item) {
@@ -258,12 +666,29 @@ class sequential_pattern_miner {
 		struct strip_sequence {
 			const std::vector<Value> &items;
 			strip_sequence(const std::vector<Value> &items) : items(items) {
-			
+				
 			}
 			
 			sequence<Value> operator()(const sequence<Value> &seq) const {
+				return strip(seq);
+			}
+			
+			sequence<Value> operator()(const sequence_view<Value> &seq) const {
+				return strip(seq);
+			}
+			
+			sequence<ordered_set<Value> > operator()(const sequence<ordered_set<Value> > &seq) const {
+				return strip_sets(seq);
+			}
+			
+			sequence<ordered_set<Value> > operator()(const sequence_view<ordered_set<Value> > &seq) const {
+				return strip_sets(seq);
+			}
+			
+			template <typename Sequence>
+			sequence<Value> strip(const Sequence &seq) const {
 				sequence<Value> new_seq;
-				typename sequence<Value>::const_iterator seq_iter = seq.begin();
+				typename Sequence::const_iterator seq_iter = seq.begin();
 				for(; seq_iter != seq.end(); ++seq_iter) {
 					if(std::binary_search(items.begin(), items.end(), *seq_iter)) {
 						new_seq.push_element(*seq_iter);
@@ -273,17 +698,18 @@ class sequential_pattern_miner {
 				return new_seq;
 			}
 			
-			sequence<ordered_set<Value> > operator()(const sequence<ordered_set<Value> > &seq) const {
+			template <typename Sequence>
+			sequence<ordered_set<Value> > strip_sets(const Sequence &seq) const {
 				sequence<ordered_set<Value> > new_seq;
 				new_seq.push_element(ordered_set<Value>());
 				
-				typename sequence<ordered_set<Value> >::const_iterator seq_iter = seq.begin();
+				typename Sequence::const_iterator seq_iter = seq.begin();
 				for(; seq_iter != seq.end(); ++seq_iter) {
-					const ordered_set<Value> &tmp_set = *seq_iter;
+					const typename std::iterator_traits<typename Sequence::const_iterator>::value_type &tmp_set = *seq_iter;
 					
 					ordered_set<Value> &new_set = new_seq.last();
 					
-					typename ordered_set<Value>::const_iterator tmp_set_iter = tmp_set.begin();
+					typename std::iterator_traits<typename Sequence::const_iterator>::value_type::const_iterator tmp_set_iter = tmp_set.begin();
 					for(; tmp_set_iter != tmp_set.end(); ++tmp_set_iter) {
 						if(std::binary_search(items.begin(), items.end(), *tmp_set_iter)) {
 							new_set.add_element(*tmp_set_iter);
@@ -301,8 +727,8 @@ class sequential_pattern_miner {
 			}
 		};
 		
-		template <template <typename, typename> class Container, typename Alloc>
-		void mine(const Container<sequence<Value1>, Alloc> &database, std::vector<Value2> &frequent_items, unsigned int min_support, bool strip_sequences, std::map<unsigned int,std::list<sequence<Value1> > > &return_patterns) const {
+		template <template <typename, typename> class Container, typename Alloc, typename Patterns>
+		void mine(const Container<sequence<Value1>, Alloc> &database, std::vector<Value2> &frequent_items, unsigned int min_support, bool strip_sequences, Patterns &return_patterns) const {
 			std::vector<sequence<Value1> > stripped_database;
 			std::vector<const sequence<Value1> *> ptr_database(database.size());
 			if(strip_sequences) {
@@ -324,37 +750,74 @@ class sequential_pattern_miner {
 				std::transform(database.begin(), database.end(), ptr_database.begin(), get_pointer());
 			}
 			
-			std::cout << "Mining: ";
-			std::cout.flush();
+			build_cooccurrences(ptr_database, frequent_items, min_support);
 			
-			time.tic();
-			mine_patterns(ptr_database, frequent_items, min_support, return_patterns);
-			std::cerr << time.toc() << ",";
-			std::cerr.flush();
+			search(ptr_database, frequent_items, min_support, return_patterns);
+		}
+		
+		template <typename Patterns>
+		void mine(const flat_database<Value1> &database, std::vector<Value2> &frequent_items, unsigned int min_support, bool strip_sequences, Patterns &return_patterns) const {
+			flat_database<Value1> stripped_database;
+			const flat_database<Value1> *tmp_database = &database;
+			if(strip_sequences) {
+				std::cout << "Strip Sequences: ";
+				std::cout.flush();
+				
+				time.tic();
+				strip_sequence<Value2> strip(frequent_items);
+				for(typename flat_database<Value1>::size_type ii=0; ii < database.size(); ii++) {
+					stripped_database.push_back(strip(database[ii]));
+				}
+				std::cerr << time.toc() << ",";
+				std::cerr.flush();
+				
+				std::cout << std::endl;
+				
+				tmp_database = &stripped_database;
+			}
 			
-			std::cout << std::endl;
+			std::vector<sequence_view<Value1> > view_database(tmp_database->begin(), tmp_database->end());
+			std::vector<const sequence_view<Value1> *> ptr_database(view_database.size());
+			std::transform(view_database.begin(), view_database.end(), ptr_database.begin(), get_pointer());
 			
-			/*print_patterns(patterns);
+			build_cooccurrences(ptr_database, frequent_items, min_support);
 			
-			*/
+			search(ptr_database, frequent_items, min_support, return_patterns);
 		}
 		
-		virtual void mine_patterns(std::vector<const sequence<Value1> *> &database, const std::vector<Value2> &items, unsigned int min_support, std::map<unsigned int,std::list<sequence<Value1> > > &return_patterns) const {
+		virtual void mine_patterns(std::vector<const sequence<Value1> *> &database, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<Value1> &return_patterns, pattern_sink<Value1> &) const {
 			#ifndef NDEBUG
 			std::cerr << __FILE__ << ":" << __LINE__ << std::endl;
 			#endif
 			
 			mine_patterns(database.begin(), database.end(), items, min_support, return_patterns);
 		}
-	
+		
+		virtual void mine_patterns(std::vector<const sequence_view<Value1> *> &database, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<Value1> &return_patterns, pattern_sink<Value1> &) const {
+			#ifndef NDEBUG
+			std::cerr << __FILE__ << ":" << __LINE__ << std::endl;
+			#endif
+			
+			mine_patterns(database.begin(), database.end(), items, min_support, return_patterns);
+		}
+		
 	private:
-		void mine_patterns(typename std::vector<const sequence<Value2> *>::iterator db_begin, typename std::vector<const sequence<Value2> *>::iterator db_end, sequence<Value2> &seq, const std::vector<Value2> &items, unsigned int min_support, std::map<unsigned int,std::list<sequence<Value2> > > &return_patterns) const {
+		template <typename Iter>
+		void mine_patterns(Iter db_begin, Iter db_end, sequence<Value2> &seq, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<Value2> &return_patterns) const {
 			//std::cout << std::distance(db_begin, db_end) << " " << seq << std::endl;
 			maintain_and_test(seq, std::distance(db_begin, db_end), return_patterns);
 			
-			typename std::vector<const sequence<Value2> *>::iterator end_iter;
+			typedef mining_task<Iter,Value2> task_type;
+			std::list<task_type> tasks;
+			bool spawn = spawn_tasks(db_begin, db_end);
+			
+			Iter end_iter;
 			typename std::vector<Value2>::const_iterator items_iter = items.begin();
 			for(; items_iter != items.end(); ++items_iter) {
+				if(!cooccurrences.sequence_extension(seq.last(), *items_iter)) {
+					continue;
+				}
+				
 				seq.push_element(*items_iter);
 				
 				//end_iter = std::partition(db_begin, db_end, is_subsequence<Value2>(seq));
@@ -365,17 +828,31 @@ class sequential_pattern_miner {
 					update_graph(seq, items);
 					#endif
 					
-					mine_patterns(db_begin, end_iter, seq, items, min_support, return_patterns);
+					if(spawn) {
+						task_type *task = create_task(tasks, db_begin, end_iter, seq, items);
+						#pragma omp task firstprivate(task, min_support)
+						mine_patterns(task->database.begin(), task->database.end(), task->seq, task->items, min_support, task->patterns);
+					}
+					else {
+						mine_patterns(db_begin, end_iter, seq, items, min_support, return_patterns);
+					}
 				}
 				
 				seq.pop_element();
 			}
+			
+			merge_tasks(tasks, return_patterns);
 		}
 		
-		void mine_patterns(typename std::vector<const sequence<Value2> *>::iterator db_begin, typename std::vector<const sequence<Value2> *>::iterator db_end, const std::vector<Value2> &items, unsigned int min_support, std::map<unsigned int,std::list<sequence<Value2> > > &return_patterns) const {
+		template <typename Iter>
+		void mine_patterns(Iter db_begin, Iter db_end, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<Value2> &return_patterns) const {
 			sequence<Value2> seq;
 			
-			typename std::vector<const sequence<Value2> *>::iterator end_iter;
+			typedef mining_task<Iter,Value2> task_type;
+			std::list<task_type> tasks;
+			bool spawn = spawn_tasks(db_begin, db_end);
+			
+			Iter end_iter;
 			typename std::vector<Value2>::const_iterator items_iter = items.begin();
 			for(; items_iter != items.end(); ++items_iter) {
 				seq.push_element(*items_iter);
@@ -387,20 +864,34 @@ class sequential_pattern_miner {
 				update_graph(seq, items);
 				#endif
 				
-				mine_patterns(db_begin, end_iter, seq, items, min_support, return_patterns);
+				if(spawn) {
+					task_type *task = create_task(tasks, db_begin, end_iter, seq, items);
+					#pragma omp task firstprivate(task, min_support)
+					mine_patterns(task->database.begin(), task->database.end(), task->seq, task->items, min_support, task->patterns);
+				}
+				else {
+					mine_patterns(db_begin, end_iter, seq, items, min_support, return_patterns);
+				}
 				
 				seq.pop_element();
 			}
+			
+			merge_tasks(tasks, return_patterns);
 		}
 		
-		void mine_patterns(typename std::vector<const sequence<ordered_set<Value2> > *>::iterator db_begin, typename std::vector<const sequence<ordered_set<Value2> > *>::iterator db_end, sequence<ordered_set<Value2> > &seq, const std::vector<Value2> &items, unsigned int min_support, std::map<unsigned int,std::list<sequence<ordered_set<Value2> > > > &return_patterns) const {
+		template <typename Iter>
+		void mine_patterns(Iter db_begin, Iter db_end, sequence<ordered_set<Value2> > &seq, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<ordered_set<Value2> > &return_patterns) const {
 			//std::cout << std::distance(db_begin, db_end) << " " << seq << std::endl;
 			maintain_and_test(seq, std::distance(db_begin, db_end), return_patterns);
 			
-			typename std::vector<const sequence<ordered_set<Value2> > *>::iterator end_iter;
+			typedef mining_task<Iter,ordered_set<Value2> > task_type;
+			std::list<task_type> tasks;
+			bool spawn = spawn_tasks(db_begin, db_end);
+			
+			Iter end_iter;
 			typename std::vector<Value2>::const_iterator items_iter = items.begin();
 			for(; items_iter != items.end(); ++items_iter) {
-				if(seq.push_item(*items_iter)) {
+				if(cooccurrences.set_extension(seq.last().get_element(), *items_iter) && seq.push_item(*items_iter)) {
 					//end_iter = std::partition(db_begin, db_end, is_subsequence<Value1>(seq));
 					end_iter = project_database(db_begin, db_end, is_subsequence<Value1>(seq), min_support);
 					
@@ -409,16 +900,28 @@ class sequential_pattern_miner {
 						update_graph(seq, items);
 						#endif
 						
-						mine_patterns(db_begin, end_iter, seq, items, min_support, return_patterns);
+						if(spawn) {
+							task_type *task = create_task(tasks, db_begin, end_iter, seq, items);
+							#pragma omp task firstprivate(task, min_support)
+							mine_patterns(task->database.begin(), task->database.end(), task->seq, task->items, min_support, task->patterns);
+						}
+						else {
+							mine_patterns(db_begin, end_iter, seq, items, min_support, return_patterns);
+						}
 					}
 					
 					seq.pop_item();
 				}
 			}
 			
+			Value2 last_item = seq.last().get_element();
 			seq.push_element(ordered_set<Value2>());
 			items_iter = items.begin();
 			for(; items_iter != items.end(); ++items_iter) {
+				if(!cooccurrences.sequence_extension(last_item, *items_iter)) {
+					continue;
+				}
+				
 				seq.push_item(*items_iter);
 				
 				//end_iter = std::partition(db_begin, db_end, is_subsequence<Value1>(seq));
@@ -429,19 +932,33 @@ class sequential_pattern_miner {
 					update_graph(seq, items);
 					#endif
 					
-					mine_patterns(db_begin, end_iter, seq, items, min_support, return_patterns);
+					if(spawn) {
+						task_type *task = create_task(tasks, db_begin, end_iter, seq, items);
+						#pragma omp task firstprivate(task, min_support)
+						mine_patterns(task->database.begin(), task->database.end(), task->seq, task->items, min_support, task->patterns);
+					}
+					else {
+						mine_patterns(db_begin, end_iter, seq, items, min_support, return_patterns);
+					}
 				}
 				
 				seq.pop_item();
 			}
 			seq.pop_element();
+			
+			merge_tasks(tasks, return_patterns);
 		}
 		
-		void mine_patterns(typename std::vector<const sequence<ordered_set<Value2> > *>::iterator db_begin, typename std::vector<const sequence<ordered_set<Value2> > *>::iterator db_end, const std::vector<Value2> &items, unsigned int min_support, std::map<unsigned int,std::list<sequence<ordered_set<Value2> > > > &return_patterns) const {
+		template <typename Iter>
+		void mine_patterns(Iter db_begin, Iter db_end, const std::vector<Value2> &items, unsigned int min_support, closed_pattern_store<ordered_set<Value2> > &return_patterns) const {
 			sequence<ordered_set<Value2> > seq;
 			seq.push_element(ordered_set<Value2>());
 			
-			typename std::vector<const sequence<ordered_set<Value2> > *>::iterator end_iter;
+			typedef mining_task<Iter,ordered_set<Value2> > task_type;
+			std::list<task_type> tasks;
+			bool spawn = spawn_tasks(db_begin, db_end);
+			
+			Iter end_iter;
 			typename std::vector<Value2>::const_iterator items_iter = items.begin();
 			for(; items_iter != items.end(); ++items_iter) {
 				seq.push_item(*items_iter);
@@ -454,13 +971,22 @@ class sequential_pattern_miner {
 					update_graph(seq, items);
 					#endif
 					
-					mine_patterns(db_begin, end_iter, seq, items, min_support, return_patterns);
+					if(spawn) {
+						task_type *task = create_task(tasks, db_begin, end_iter, seq, items);
+						#pragma omp task firstprivate(task, min_support)
+						mine_patterns(task->database.begin(), task->database.end(), task->seq, task->items, min_support, task->patterns);
+					}
+					else {
+						mine_patterns(db_begin, end_iter, seq, items, min_support, return_patterns);
+					}
 				}
 				
 				seq.pop_item();
 			}
 			
 			seq.pop_element();
+			
+			merge_tasks(tasks, return_patterns);
 		}
 		
 };
@@ -22,8 +22,14 @@
 
 #include <cstring>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "ordered_set.hh"
 #include "sequence.hh"
+#include "sequence_parser.hh"
+#include "gzip_reader.hh"
 
 #include "timer.hh"
 
@@ -34,26 +40,30 @@
 void usage(const char *file_name) {
 	std::cout << "Subgroup Discovery" << std::endl << std::endl;
 	
-	std::cout << "Usage:  " << file_name << " [-n/--numeric] [-i/--itemset] [-s/--strip-sequences]" << std::endl;
+	std::cout << "Usage:  " << file_name << " [-n/--numeric] [-i/--itemset] [-s/--strip-sequences] [-e/--exhaustive]" << std::endl;
 	std::cout << "          [-m/--min-support n] [-b/--beam-width n ] [-g/--generalization n]" << std::endl;
-	std::cout << "          [-o/--outfile file] infile" << std::endl;
+	std::cout << "          [-t/--threads n] [-o/--outfile file] infile" << std::endl;
 	std::cout << "  --itemset           treat items as sets " << std::endl;
 	std::cout << "  --numeric           sequence items are treated as nonnegative integers" << std::endl;
 	std::cout << "  --strip-sequences   strip non-frequent items from database, default false" << std::endl;
+	std::cout << "  --exhaustive        find the beam width best subgroups exactly, by a pruned search of all patterns" << std::endl;
 	std::cout << "  --min-support       minimum support, number between 0.0 and 1.0, default 0.25" << std::endl;
 	std::cout << "  --beam-width        number of solutions keept on each iteration, default 20" << std::endl;
 	std::cout << "  --generalization    generalization parameter, default 1.0" << std::endl;
+	std::cout << "  --threads           number of threads evaluating the candidates of a beam, default 1" << std::endl;
 	std::cout << "  --outfile           write results to the specified file" << std::endl;
 	std::cout << "  infile              input sequence database" << std::endl;
 }
 
-bool parse_args(int argc, char *argv[], bool &numeric, bool &itemset, bool &strip_sequences, double &min_support, unsigned int &beam_width, double &generalization, std::string &outfile, std::string &infile) {
+bool parse_args(int argc, char *argv[], bool &numeric, bool &itemset, bool &strip_sequences, bool &exhaustive, double &min_support, unsigned int &beam_width, double &generalization, unsigned int &threads, std::string &outfile, std::string &infile) {
 	numeric = false;
 	itemset = false;
 	strip_sequences = false;
+	exhaustive = false;
 	min_support = 0.25;
 	beam_width = 20;
 	generalization = 1.0;
+	threads = 1;
 	outfile.clear();
 	infile.clear();
 	
@@ -79,6 +89,9 @@ bool parse_args(int argc, char *argv[], bool &numeric, bool &itemset, bool &stri
 			else if(strcmp(argv[ii], "-s") == 0 || strcmp(argv[ii], "--strip-sequences") == 0) {
 				strip_sequences = true;
 			}
+			else if(strcmp(argv[ii], "-e") == 0 || strcmp(argv[ii], "--exhaustive") == 0) {
+				exhaustive = true;
+			}
 			else if(strcmp(argv[ii], "-m") == 0 || strcmp(argv[ii], "--min-support") == 0) {
 				ii++;
 				if(ii >= argc) {
@@ -95,13 +108,13 @@ bool parse_args(int argc, char *argv[], bool &numeric, bool &itemset, bool &stri
 					if(min_support == std::numeric_limits<double>::max()) {
 						std::cerr << "Minimum support specified exceeds maximum allowed value." << std::endl << std::endl;
 						usage(argv[0]);
-					
+						
 						return false;
 					}
 					else if(min_support == std::numeric_limits<double>::min()) {
 						std::cerr << "Minimum support specified less than minimum allowed value." << std::endl << std::endl;
 						usage(argv[0]);
-					
+						
 						return false;
 					}
 					else {
@@ -114,7 +127,7 @@ bool parse_args(int argc, char *argv[], bool &numeric, bool &itemset, bool &stri
 				else if(min_support <= 0.0 || min_support > 1.0) {
 					std::cerr << "Minimum support must be a value between 0.0 and 1.0." << std::endl << std::endl;
 					usage(argv[0]);
-				
+					
 					return false;
 				}
 			}
@@ -134,13 +147,13 @@ bool parse_args(int argc, char *argv[], bool &numeric, bool &itemset, bool &stri
 					if(beam_width == std::numeric_limits<unsigned int>::max()) {
 						std::cerr << "Beam width specified exceeds maximum allowed value." << std::endl << std::endl;
 						usage(argv[0]);
-					
+						
 						return false;
 					}
 					else if(beam_width == std::numeric_limits<unsigned int>::min()) {
 						std::cerr << "Beam width specified less than minimum allowed value." << std::endl << std::endl;
 						usage(argv[0]);
-					
+						
 						return false;
 					}
 					else {
@@ -153,7 +166,7 @@ bool parse_args(int argc, char *argv[], bool &numeric, bool &itemset, bool &stri
 				else if(beam_width == 0) {
 					std::cerr << "Beam width must be a positive integer." << std::endl << std::endl;
 					usage(argv[0]);
-				
+					
 					return false;
 				}
 			}
@@ -173,13 +186,13 @@ bool parse_args(int argc, char *argv[], bool &numeric, bool &itemset, bool &stri
 					if(generalization == std::numeric_limits<double>::max()) {
 						std::cerr << "Generalization parameter specified exceeds maximum allowed value." << std::endl << std::endl;
 						usage(argv[0]);
-					
+						
 						return false;
 					}
 					else if(generalization == std::numeric_limits<double>::min()) {
 						std::cerr << "Generalization parameter specified less than minimum allowed value." << std::endl << std::endl;
 						usage(argv[0]);
-					
+						
 						return false;
 					}
 					else {
@@ -190,6 +203,31 @@ bool parse_args(int argc, char *argv[], bool &numeric, bool &itemset, bool &stri
 					}
 				}
 			}
+			else if(strcmp(argv[ii], "-t") == 0 || strcmp(argv[ii], "--threads") == 0) {
+				ii++;
+				if(ii >= argc) {
+					std::cerr << "Option " << argv[ii-1] << " requires an argument." << std::endl << std::endl;
+					usage(argv[0]);
+					
+					return false;
+				}
+				
+				std::istringstream iss(argv[ii]);
+				iss >> threads;
+				
+				if(iss.bad() || iss.fail() || !iss.eof()) {
+					std::cerr << "Option " << argv[ii-1] << " requires an integer value." << std::endl << std::endl;
+					usage(argv[0]);
+					
+					return false;
+				}
+				else if(threads == 0) {
+					std::cerr << "Number of threads must be a positive integer." << std::endl << std::endl;
+					usage(argv[0]);
+					
+					return false;
+				}
+			}
 			else if(strcmp(argv[ii], "-o") == 0 || strcmp(argv[ii], "--outfile") == 0) {
 				ii++;
 				if(ii >= argc) {
@@ -229,41 +267,21 @@ template <typename Value>
 void read_database(const std::string &file_name, std::list<std::pair<bool,sequence<Value> > > &database) {
 	timer<long double> time;
 	
-	std::ifstream file(file_name.c_str());
-	if(file) {
-		std::cout << "Read Time: ";
-		std::cout.flush();
-		
-		database.clear();
-		
-		time.tic();
-		
-		std::pair<bool,sequence<Value> > item;
-		while(file >> item.second && file >> item.first) {
-			database.push_back(item);
-		}
-
-		std::cerr << time.toc() << ",";
-		std::cerr.flush();
-		
-		std::cout << std::endl;
-		
-		if(file.bad()) {
-			std::ostringstream oss;
-			oss <<  file_name << ": " << strerror(errno);
-			
-			throw std::runtime_error(oss.str());
-		}
-		else if(file.fail() && !file.eof()) {
-			std::ostringstream oss;
-			oss <<  file_name << ": error reading file";
-			
-			throw std::runtime_error(oss.str());
-		}
-	}
-	else {
+	std::cout << "Read Time: ";
+	std::cout.flush();
+	
+	database.clear();
+	
+	time.tic();
+	bool parsed = parse_database_file(file_name, database, true);
+	std::cerr << time.toc() << ",";
+	std::cerr.flush();
+	
+	std::cout << std::endl;
+	
+	if(!parsed) {
 		std::ostringstream oss;
-		oss <<  file_name << ": " << strerror(errno);
+		oss <<  file_name << ": error reading file";
 		
 		throw std::runtime_error(oss.str());
 	}
@@ -280,15 +298,20 @@ std::ostream & operator<<(std::ostream &output, const std::vector<std::pair<doub
 }
 
 template <template <typename, typename> class Miner, typename Value1, typename Value2>
-void mine(std::list<std::pair<bool,sequence<Value1> > > &database, const std::string &outfile, double min_support, unsigned int beam_width, double generalization, bool strip_sequences, const Miner<Value1,Value2> &miner) {
+void mine(std::list<std::pair<bool,sequence<Value1> > > &database, const std::string &outfile, double min_support, unsigned int beam_width, double generalization, bool strip_sequences, bool exhaustive, const Miner<Value1,Value2> &miner) {
 	std::vector<std::pair<double,sequence<Value1> > > patterns;
 	
-	miner.beam_mine(database, min_support, beam_width, generalization, strip_sequences, patterns);
+	if(exhaustive) {
+		miner.mine(database, min_support, beam_width, generalization, strip_sequences, patterns);
+	}
+	else {
+		miner.beam_mine(database, min_support, beam_width, generalization, strip_sequences, patterns);
+	}
 	
 	if(!outfile.empty()) {
 		std::ofstream output(outfile.c_str());
 		if(output) {
-			std::sort_heap(patterns.begin(), patterns.end(), std::greater<std::pair<double,sequence<Value2> > >());
+			std::sort_heap(patterns.begin(), patterns.end(), std::greater<std::pair<double,sequence<Value1> > >());
 			output << patterns << std::endl;
 			if(output.bad()) {
 				std::ostringstream oss;
@@ -307,7 +330,7 @@ void mine(std::list<std::pair<bool,sequence<Value1> > > &database, const std::st
 }
 
 template <template <typename, typename> class Miner, typename Value1, typename Value2>
-void mine(const std::string &database_file, const std::string &outfile, double min_support, unsigned int beam_width, double generalization, bool strip_sequences, const Miner<Value1,Value2> &miner) {
+void mine(const std::string &database_file, const std::string &outfile, double min_support, unsigned int beam_width, double generalization, bool strip_sequences, bool exhaustive, const Miner<Value1,Value2> &miner) {
 	std::cout << "Min Support: ";
 	std::cout.flush();
 	std::cerr << min_support << ",";
@@ -317,14 +340,22 @@ void mine(const std::string &database_file, const std::string &outfile, double m
 	std::list<std::pair<bool,sequence<Value1> > > database;
 	read_database(database_file, database);
 	
-	mine(database, outfile, min_support, beam_width, generalization, strip_sequences, miner);	
+	mine(database, outfile, min_support, beam_width, generalization, strip_sequences, exhaustive, miner);	
 }
 
 template <template <typename, typename> class Miner, typename Value1, typename Value2>
-void run(double min_support, unsigned int beam_width, double generalization, bool strip_sequences, const std::string &infile, const std::string &outfile, const Miner<Value1,Value2> &miner) {
+void run(double min_support, unsigned int beam_width, double generalization, bool strip_sequences, bool exhaustive, unsigned int threads, const std::string &infile, const std::string &outfile, const Miner<Value1,Value2> &miner) {
 	timer<long double> time;			
-			
-	mine(infile, outfile, min_support, beam_width, generalization, strip_sequences, miner);
+	
+	#ifdef _OPENMP
+	omp_set_num_threads(threads);
+	#else
+	if(threads > 1) {
+		std::cerr << "warning: compiled without OpenMP, mining with a single thread" << std::endl;
+	}
+	#endif
+	
+	mine(infile, outfile, min_support, beam_width, generalization, strip_sequences, exhaustive, miner);
 	
 	std::cout << "Total: ";
 	std::cout.flush();
@@ -335,27 +366,27 @@ void run(double min_support, unsigned int beam_width, double generalization, boo
 template <template <typename, typename> class Miner>
 int run(int argc, char *argv[]) {
 	bool numeric, itemset;
-	bool strip_sequences;
+	bool strip_sequences, exhaustive;
 	double min_support, generalization;
-	unsigned int beam_width;
+	unsigned int beam_width, threads;
 	std::string output_name, database_name;
 	
-	if(parse_args(argc, argv, numeric, itemset, strip_sequences, min_support, beam_width, generalization, output_name, database_name)) {
+	if(parse_args(argc, argv, numeric, itemset, strip_sequences, exhaustive, min_support, beam_width, generalization, threads, output_name, database_name)) {
 		try {
 			if(itemset) {
 				if(numeric) {
-					run(min_support, beam_width, generalization, strip_sequences, database_name, output_name, Miner<ordered_set<int>,int>());
+					run(min_support, beam_width, generalization, strip_sequences, exhaustive, threads, database_name, output_name, Miner<ordered_set<int>,int>());
 				}
 				else {
-					run(min_support, beam_width, generalization, strip_sequences, database_name, output_name, Miner<ordered_set<std::string>,std::string>());
+					run(min_support, beam_width, generalization, strip_sequences, exhaustive, threads, database_name, output_name, Miner<ordered_set<std::string>,std::string>());
 				}
 			}
 			else {
 				if(numeric) {
-					run(min_support, beam_width, generalization, strip_sequences, database_name, output_name, Miner<int,int>());
+					run(min_support, beam_width, generalization, strip_sequences, exhaustive, threads, database_name, output_name, Miner<int,int>());
 				}
 				else {
-					run(min_support, beam_width, generalization, strip_sequences, database_name, output_name, Miner<std::string,std::string>());
+					run(min_support, beam_width, generalization, strip_sequences, exhaustive, threads, database_name, output_name, Miner<std::string,std::string>());
 				}
 			}
 		}
@@ -17,9 +17,14 @@
 
 #include <cmath>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "timer.hh"
 #include "ordered_set.hh"
 #include "sequence.hh"
+#include "itemset_masks.hh"
 
 #include "maintain_and_test.hh"
 
@@ -59,7 +64,7 @@ template <typename Value1, typename Value2>
 class subgroup_miner {
 	public:
 		template <template <typename, typename> class Container, typename Alloc>
-		void mine(const Container<std::pair<bool,sequence<Value1> >, Alloc> &database, double relative_support, double generalization, bool strip_sequences, std::vector<std::pair<double,sequence<Value1> > > &return_patterns) const {
+		void mine(const Container<std::pair<bool,sequence<Value1> >, Alloc> &database, double relative_support, unsigned int top_k, double generalization, bool strip_sequences, std::vector<std::pair<double,sequence<Value1> > > &return_patterns) const {
 			if(relative_support < 0.0 || relative_support > 1.0) {
 				std::ostringstream oss;
 				oss << "domain error: invalid support (" << relative_support << "): support must be between 0.0 and 1.0";
@@ -74,7 +79,7 @@ class subgroup_miner {
 				}
 			}
 			
-			mine(database, (unsigned int) ceil(positive_count * relative_support), generalization, strip_sequences, return_patterns);
+			mine(database, (unsigned int) ceil(positive_count * relative_support), top_k, generalization, strip_sequences, return_patterns);
 		}
 		
 		template <template <typename, typename> class Container, typename Alloc>
@@ -98,7 +103,7 @@ class subgroup_miner {
 		
 
 		template <template <typename, typename> class Container, typename Alloc>
-		void mine(const Container<std::pair<bool,sequence<Value1> >, Alloc> &database, unsigned int absolute_support, double generalization, bool strip_sequences, std::vector<std::pair<double,sequence<Value1> > > &return_patterns) const {
+		void mine(const Container<std::pair<bool,sequence<Value1> >, Alloc> &database, unsigned int absolute_support, unsigned int top_k, double generalization, bool strip_sequences, std::vector<std::pair<double,sequence<Value1> > > &return_patterns) const {
 			std::set<Value2> itemset;
 
 			std::cout << "Extract Items: ";
@@ -111,7 +116,7 @@ class subgroup_miner {
 
 			std::cout << std::endl;
 
-			mine(database, itemset, absolute_support, generalization, strip_sequences, return_patterns);
+			mine(database, itemset, absolute_support, top_k, generalization, strip_sequences, return_patterns);
 		}
 		
 		template <template <typename, typename> class Container, typename Alloc>
@@ -132,7 +137,7 @@ class subgroup_miner {
 		}
 
 		template <template <typename, typename> class Container, typename Alloc>
-		void mine(const Container<std::pair<bool,sequence<Value1> >, Alloc> &database, const std::set<Value2> &items, double relative_support, double generalization, bool strip_sequences, std::vector<std::pair<double,sequence<Value1> > > &return_patterns) const {
+		void mine(const Container<std::pair<bool,sequence<Value1> >, Alloc> &database, const std::set<Value2> &items, double relative_support, unsigned int top_k, double generalization, bool strip_sequences, std::vector<std::pair<double,sequence<Value1> > > &return_patterns) const {
 			unsigned int positive_count=0;
 			typename Container<std::pair<bool,sequence<Value1> >, Alloc>::const_iterator database_iter = database.begin();
 			for(; database_iter != database.end(); ++database_iter) {
@@ -141,7 +146,7 @@ class subgroup_miner {
 				}
 			}
 
-			mine(database, items, (unsigned int) ceil(positive_count * relative_support), generalization, strip_sequences, return_patterns);
+			mine(database, items, (unsigned int) ceil(positive_count * relative_support), top_k, generalization, strip_sequences, return_patterns);
 		}
 		
 		template <template <typename, typename> class Container, typename Alloc>
@@ -158,7 +163,7 @@ class subgroup_miner {
 		}
 
 		template <template <typename, typename> class Container, typename Alloc>
-		void mine(const Container<std::pair<bool,sequence<Value1> >, Alloc> &database, const std::set<Value2> &items, unsigned int absolute_support, double generalization, bool strip_sequences, std::vector<std::pair<double,sequence<Value1> > > &return_patterns) const {
+		void mine(const Container<std::pair<bool,sequence<Value1> >, Alloc> &database, const std::set<Value2> &items, unsigned int absolute_support, unsigned int top_k, double generalization, bool strip_sequences, std::vector<std::pair<double,sequence<Value1> > > &return_patterns) const {
 			std::vector<Value2> frequent_items;
 
 			std::cout << "Extract Frequent Items: ";
@@ -171,7 +176,7 @@ class subgroup_miner {
 
 			std::cout << std::endl;
 
-			mine(database, frequent_items, absolute_support, generalization, strip_sequences, return_patterns);
+			mine(database, frequent_items, absolute_support, top_k, generalization, strip_sequences, return_patterns);
 		}
 		
 		template <template <typename, typename> class Container, typename Alloc>
@@ -341,7 +346,7 @@ class subgroup_miner {
 		};
 
 		template <template <typename, typename> class Container, typename Alloc>
-		void mine(const Container<std::pair<bool,sequence<Value1> >, Alloc> &database, std::vector<Value2> &frequent_items, unsigned int min_support, double generalization, bool strip_sequences, std::vector<std::pair<double,sequence<Value1> > > &return_patterns) const {
+		void mine(const Container<std::pair<bool,sequence<Value1> >, Alloc> &database, std::vector<Value2> &frequent_items, unsigned int min_support, unsigned int top_k, double generalization, bool strip_sequences, std::vector<std::pair<double,sequence<Value1> > > &return_patterns) const {
 			std::vector<std::pair<bool,sequence<Value1> > > stripped_database;
 			std::vector<const std::pair<bool,sequence<Value1> > *> ptr_database(database.size());
 			if(strip_sequences) {
@@ -369,7 +374,7 @@ class subgroup_miner {
 			std::cout.flush();
 
 			time.tic();
-			//mine_patterns(ptr_database, frequent_items, min_support, generalization, return_patterns);
+			exhaustive_search(ptr_database, frequent_items, min_support, top_k, generalization, return_patterns);
 			std::cerr << time.toc() << ",";
 			std::cerr.flush();
 
@@ -438,84 +443,768 @@ class subgroup_miner {
 			}
 		}
 		
+		/* the sequences of the database holding a beam pattern, and in each of
+		 * them the end of the leftmost embedding of every prefix of the pattern,
+		 * ends[kk * (length + 1) + jj] for the prefix of length jj in ids[kk] */
+		struct pattern_cover {
+			std::vector<unsigned int> ids;
+			std::vector<unsigned int> ends;
+		};
+		
+		/* a pattern of the next beam, with the beam member it extends */
+		struct beam_candidate {
+			std::pair<double,sequence<Value1> > pattern;
+			unsigned int parent;
+			typename sequence<Value1>::size_type position;
+			
+			bool operator<(const beam_candidate &other) const {
+				return pattern < other.pattern;
+			}
+			
+			bool operator>(const beam_candidate &other) const {
+				return other.pattern < pattern;
+			}
+		};
+		
+		/* adds candidate to heap, a min-heap of at most beam_width candidates,
+		 * when it is among the best seen so far */
+		void keep_candidate(std::vector<beam_candidate> &heap, const beam_candidate &candidate, unsigned int beam_width) const {
+			if(heap.size() < beam_width) {
+				heap.push_back(candidate);
+				std::push_heap(heap.begin(), heap.end(), std::greater<beam_candidate>());
+			}
+			else if(heap.front() < candidate) {
+				std::pop_heap(heap.begin(), heap.end(), std::greater<beam_candidate>());
+				heap.back() = candidate;
+				std::push_heap(heap.begin(), heap.end(), std::greater<beam_candidate>());
+			}
+		}
+		
+		/* the cover of every sequence of the database for the empty pattern */
+		template <typename Sequence>
+		void start_cover(const std::vector<const std::pair<bool,Sequence> *> &database, pattern_cover &cover) const {
+			cover.ids.resize(database.size());
+			cover.ends.assign(database.size(), 0);
+			for(unsigned int ii=0; ii < database.size(); ii++) {
+				cover.ids[ii] = ii;
+			}
+		}
+		
+		/* counts the sequences holding seq among those of cover, the cover of seq
+		 * without its element at position. the prefix before position is already
+		 * embedded, so matching starts from its end. when new_cover is given the
+		 * cover of seq is stored in it */
+		void fitness(const std::vector<const std::pair<bool,sequence<Value2> > *> &database, const pattern_cover &cover, const sequence<Value2> &seq, typename sequence<Value2>::size_type position, unsigned int &TP, unsigned int &FP, pattern_cover *new_cover=NULL) const {
+			TP = 0;
+			FP = 0;
+			
+			typename sequence<Value2>::size_type length = seq.length();
+			if(new_cover) {
+				new_cover->ids.clear();
+				new_cover->ends.clear();
+			}
+			
+			for(std::size_t kk=0; kk < cover.ids.size(); kk++) {
+				const sequence<Value2> &data = database[cover.ids[kk]]->second;
+				const unsigned int *ends = &cover.ends[kk * length];
+				
+				typename sequence<Value2>::const_iterator data_iter = data.begin() + ends[position];
+				typename sequence<Value2>::size_type jj = position;
+				for(; jj < length; jj++) {
+					data_iter = std::find(data_iter, data.end(), seq[jj]);
+					if(data_iter == data.end()) {
+						break;
+					}
+					++data_iter;
+					
+					if(new_cover) {
+						new_cover->ends.push_back(data_iter - data.begin());
+					}
+				}
+				
+				if(jj < length) {
+					if(new_cover) {
+						new_cover->ends.resize(new_cover->ids.size() * (length + 1));
+					}
+					continue;
+				}
+				
+				if(new_cover) {
+					new_cover->ids.push_back(cover.ids[kk]);
+					new_cover->ends.insert(new_cover->ends.end() - (length - position), ends, ends + position + 1);
+				}
+				
+				if(database[cover.ids[kk]]->first) {
+					TP++;
+				}
+				else {
+					FP++;
+				}
+			}
+		}
+		
+		/* every candidate only occurs in sequences holding the beam member it
+		 * extends, so the database is narrowed to the cover of each member and its
+		 * TP/FP counted from there. the insertion points of the beam members are
+		 * shared among the threads, each keeping its own best beam_width
+		 * candidates. only the best beam_width of all of them make the next beam,
+		 * so merging the heaps gives the same beam as a single thread */
 		void beam_search(std::vector<const std::pair<bool,sequence<Value2> > *> &database, const std::vector<Value2> &items, unsigned int min_support, unsigned int beam_width, double generalization, std::vector<std::pair<double,sequence<Value2> > > &results) const {
 			unsigned int TP, FP;
-			std::pair<double,sequence<Value2> > element;
+			beam_candidate element;
 			std::vector<std::pair<double,sequence<Value2> > > beam;
-			std::vector<std::pair<double,sequence<Value2> > > next_beam;
+			std::vector<pattern_cover> covers;
+			std::vector<beam_candidate> next_beam;
+			
+			beam.push_back(element.pattern);
+			covers.resize(1);
+			start_cover(database, covers.back());
+			unsigned int threads = 1;
+			#ifdef _OPENMP
+			threads = omp_get_max_threads();
+			#endif
 			
-			beam.push_back(element);
 			while( !beam.empty() ) {
-				next_beam.clear();
-
-				typename std::vector<std::pair<double,sequence<Value2> > >::iterator beam_iter = beam.begin();
-				for(; beam_iter != beam.end(); ++beam_iter) {
+				std::vector<std::pair<unsigned int,typename sequence<Value2>::size_type> > units;
+				for(unsigned int bb=0; bb < beam.size(); bb++) {
+					for(typename sequence<Value2>::size_type ii=0; ii <= beam[bb].second.length(); ii++) {
+						units.push_back(std::pair<unsigned int,typename sequence<Value2>::size_type>(bb, ii));
+					}
+				}
+				
+				std::vector<std::vector<beam_candidate> > heaps(threads);
+				#pragma omp parallel if(threads > 1)
+				{
+					unsigned int thread = 0;
+					#ifdef _OPENMP
+					thread = omp_get_thread_num();
+					#endif
+					
+					beam_candidate candidate;
+					unsigned int candidate_TP, candidate_FP;
 					
-					typename sequence<Value2>::size_type len = beam_iter->second.length();	
-					for(typename sequence<Value2>::size_type ii=0; ii < len; ii++) {
+					#pragma omp for schedule(dynamic)
+					for(int uu=0; uu < (int) units.size(); uu++) {
+						candidate.parent = units[uu].first;
+						candidate.position = units[uu].second;
+						candidate.pattern.second = beam[candidate.parent].second;
+						
 						typename std::vector<Value2>::const_iterator items_iter = items.begin();
 						for(; items_iter != items.end(); ++items_iter) {
-							beam_iter->second.insert(*items_iter, ii);
-
-							fitness(database, beam_iter->second, TP, FP);
-							if(TP >= min_support) {
-								beam_iter->first = TP/(FP+generalization);
-								next_beam.push_back(*beam_iter);
-							}   
-
-							beam_iter->second.remove(ii);
+							candidate.pattern.second.insert(*items_iter, candidate.position);
+							
+							fitness(database, covers[candidate.parent], candidate.pattern.second, candidate.position, candidate_TP, candidate_FP);
+							if(candidate_TP >= min_support) {
+								candidate.pattern.first = candidate_TP/(candidate_FP+generalization);
+								keep_candidate(heaps[thread], candidate, beam_width);
+							}
+							
+							candidate.pattern.second.remove(candidate.position);
 						}
 					}
-					
-					typename std::vector<Value2>::const_iterator items_iter = items.begin();
-					for(; items_iter != items.end(); ++items_iter) {
-						beam_iter->second.push_element(*items_iter);
-
-						fitness(database, beam_iter->second, TP, FP);
-						if(TP >= min_support) {
-							beam_iter->first = TP/(FP+generalization);
-							next_beam.push_back(*beam_iter);
-						}   
-
-						beam_iter->second.pop_element();
-					}
 				}
-
+				
+				next_beam.clear();
+				for(unsigned int tt=0; tt < threads; tt++) {
+					next_beam.insert(next_beam.end(), heaps[tt].begin(), heaps[tt].end());
+				}
+				
 				std::make_heap(next_beam.begin(), next_beam.end());
 				
-				beam.clear();
+				std::vector<std::pair<double,sequence<Value2> > > parents;
+				std::vector<pattern_cover> parent_covers;
+				beam.swap(parents);
+				covers.swap(parent_covers);
+				
 				while(beam.size() < beam_width && next_beam.size() > 0) {
 					element = next_beam.front();
-					std::pop_heap(next_beam.begin(), next_beam.end()); 
+					std::pop_heap(next_beam.begin(), next_beam.end());
 					next_beam.pop_back();
 					
-					beam.push_back(element);
+					beam.push_back(element.pattern);
+					covers.push_back(pattern_cover());
+					fitness(database, parent_covers[element.parent], element.pattern.second, element.position, TP, FP, &covers.back());
+					
 					if(results.size() < beam_width) {
-						results.push_back(element);
+						results.push_back(element.pattern);
 						std::push_heap(results.begin(), results.end(), std::greater<std::pair<double,sequence<Value2> > >());
 					}
-					else if(element.first > results.front().first) {
+					else if(element.pattern.first > results.front().first) {
 						std::pop_heap(results.begin(), results.end(), std::greater<std::pair<double,sequence<Value2> > >());
-						results.back() = element;
+						results.back() = element.pattern;
 						std::push_heap(results.begin(), results.end(), std::greater<std::pair<double,sequence<Value2> > >());
 					}
 				}
-
+				
+			}
+		}
+		
+		/* subset tests of pattern elements against the elements of the database
+		 * sequences, on bit masks of the frequent items */
+		struct mask_elements {
+			typedef typename itemset_masks<Value2>::word_type word_type;
+			typedef std::vector<word_type> element_type;
+			
+			itemset_masks<Value2> masks;
+			std::vector<std::vector<word_type> > sequences;
+			
+			mask_elements(const std::vector<const std::pair<bool,sequence<ordered_set<Value2> > > *> &database, const std::vector<Value2> &items) : masks(items), sequences(database.size()) {
+				for(std::size_t ii=0; ii < database.size(); ii++) {
+					const sequence<ordered_set<Value2> > &seq = database[ii]->second;
+					
+					sequences[ii].reserve(seq.length() * masks.words());
+					typename sequence<ordered_set<Value2> >::const_iterator seq_iter = seq.begin();
+					for(; seq_iter != seq.end(); ++seq_iter) {
+						masks.add(*seq_iter, sequences[ii]);
+					}
+				}
+			}
+			
+			void element(const ordered_set<Value2> &set, element_type &mask) const {
+				mask.clear();
+				masks.add(set, mask);
+			}
+			
+			/* moves position to the first element of sequence id at or after it
+			 * holding element, false if there is none */
+			bool find(unsigned int id, unsigned int &position, const element_type &element) const {
+				const std::vector<word_type> &seq = sequences[id];
+				std::size_t words = masks.words();
+				std::size_t length = seq.size() / words;
+				
+				/* up to one word of items, the common case, tests a single and */
+				if(words == 1) {
+					word_type mask = element[0];
+					for(; position < length; position++) {
+						if(!(mask & ~seq[position])) {
+							return true;
+						}
+					}
+					
+					return false;
+				}
+				
+				for(; position < length; position++) {
+					if(masks.subset(&element[0], &seq[position * words])) {
+						return true;
+					}
+				}
+				
+				return false;
+			}
+		};
+		
+		/* the same on the sorted elements themselves, for alphabets too large to
+		 * give every element of the database a mask */
+		struct set_elements {
+			typedef ordered_set<Value2> element_type;
+			
+			const std::vector<const std::pair<bool,sequence<ordered_set<Value2> > > *> &database;
+			
+			set_elements(const std::vector<const std::pair<bool,sequence<ordered_set<Value2> > > *> &database) : database(database) {
+				
+			}
+			
+			void element(const ordered_set<Value2> &set, element_type &element) const {
+				element = set;
+			}
+			
+			bool find(unsigned int id, unsigned int &position, const element_type &element) const {
+				const sequence<ordered_set<Value2> > &seq = database[id]->second;
+				
+				for(; position < seq.length(); position++) {
+					if(element.subset(seq[position])) {
+						return true;
+					}
+				}
+				
+				return false;
+			}
+		};
+		
+		/* masks are used up to this many words per element */
+		static const std::size_t max_mask_words = 8;
+		
+		/* the pattern extending parent by item in extension unit. the units up to
+		 * the length of parent insert the element (item) at that position (an
+		 * S-extension), the others add item to element unit - length - 1 (an
+		 * I-extension). position is set to the element that changed, false when
+		 * that element already holds item */
+		bool extend(const sequence<ordered_set<Value2> > &parent, typename sequence<ordered_set<Value2> >::size_type unit, const Value2 &item, sequence<ordered_set<Value2> > &pattern, typename sequence<ordered_set<Value2> >::size_type &position) const {
+			typename sequence<ordered_set<Value2> >::size_type length = parent.length();
+			bool new_element = unit <= length;
+			
+			position = new_element ? unit : unit - length - 1;
+			if(!new_element && parent[position].contains(item)) {
+				return false;
+			}
+			
+			pattern.clear();
+			for(typename sequence<ordered_set<Value2> >::size_type ii=0; ii < length; ii++) {
+				if(ii == position) {
+					if(new_element) {
+						pattern.push_element(ordered_set<Value2>(item));
+					}
+					else {
+						pattern.push_element(ordered_set<Value2>());
+						
+						bool added = false;
+						typename ordered_set<Value2>::const_iterator set_iter = parent[ii].begin();
+						for(; set_iter != parent[ii].end(); ++set_iter) {
+							if(!added && item < *set_iter) {
+								pattern.push_item(item);
+								added = true;
+							}
+							pattern.push_item(*set_iter);
+						}
+						
+						if(!added) {
+							pattern.push_item(item);
+						}
+						continue;
+					}
+				}
+				
+				pattern.push_element(parent[ii]);
+			}
+			
+			if(position == length) {
+				pattern.push_element(ordered_set<Value2>(item));
+			}
+			
+			return true;
+		}
+		
+		/* the elements of pattern in the form Elements tests them */
+		template <typename Elements>
+		void pattern_elements(const Elements &elements, const sequence<ordered_set<Value2> > &pattern, std::vector<typename Elements::element_type> &result) const {
+			result.resize(pattern.length());
+			for(typename sequence<ordered_set<Value2> >::size_type ii=0; ii < pattern.length(); ii++) {
+				elements.element(pattern[ii], result[ii]);
+			}
+		}
+		
+		/* counts the sequences holding pattern among those of cover, the cover of
+		 * a pattern of parent_length elements sharing the first position elements
+		 * with pattern. an element of pattern is embedded in the first element of
+		 * a sequence holding all its items */
+		template <typename Elements>
+		void fitness(const std::vector<const std::pair<bool,sequence<ordered_set<Value2> > > *> &database, const Elements &elements, const pattern_cover &cover, typename sequence<ordered_set<Value2> >::size_type parent_length, const std::vector<typename Elements::element_type> &pattern, typename sequence<ordered_set<Value2> >::size_type position, unsigned int &TP, unsigned int &FP, pattern_cover *new_cover=NULL) const {
+			TP = 0;
+			FP = 0;
+			
+			typename sequence<ordered_set<Value2> >::size_type length = pattern.size();
+			if(new_cover) {
+				new_cover->ids.clear();
+				new_cover->ends.clear();
+			}
+			
+			for(std::size_t kk=0; kk < cover.ids.size(); kk++) {
+				unsigned int id = cover.ids[kk];
+				const unsigned int *ends = &cover.ends[kk * (parent_length + 1)];
+				
+				unsigned int data_position = ends[position];
+				typename sequence<ordered_set<Value2> >::size_type jj = position;
+				for(; jj < length; jj++) {
+					if(!elements.find(id, data_position, pattern[jj])) {
+						break;
+					}
+					data_position++;
+					
+					if(new_cover) {
+						new_cover->ends.push_back(data_position);
+					}
+				}
+				
+				if(jj < length) {
+					if(new_cover) {
+						new_cover->ends.resize(new_cover->ids.size() * (length + 1));
+					}
+					continue;
+				}
+				
+				if(new_cover) {
+					new_cover->ids.push_back(id);
+					new_cover->ends.insert(new_cover->ends.end() - (length - position), ends, ends + position + 1);
+				}
+				
+				if(database[id]->first) {
+					TP++;
+				}
+				else {
+					FP++;
+				}
 			}
 		}
 		
+		/* the beam search of sequences of itemsets, on masks when the frequent
+		 * items fit in a few words */
 		void beam_search(std::vector<const std::pair<bool,sequence<ordered_set<Value2 > > > *> &database, const std::vector<Value2> &items, unsigned int min_support, unsigned int beam_width, double generalization, std::vector<std::pair<double,sequence<ordered_set<Value2> > > > &results) const {
-				throw std::runtime_error("not yet implemented");
+			if(itemset_masks<Value2>(items).words() <= max_mask_words) {
+				beam_search(database, mask_elements(database, items), items, min_support, beam_width, generalization, results);
+			}
+			else {
+				beam_search(database, set_elements(database), items, min_support, beam_width, generalization, results);
+			}
+		}
+		
+		/* as for sequences, with both ways of growing a pattern of itemsets as
+		 * extension units of every beam member: inserting a new element (item)
+		 * anywhere, and adding item to one of its elements */
+		template <typename Elements>
+		void beam_search(std::vector<const std::pair<bool,sequence<ordered_set<Value2 > > > *> &database, const Elements &elements, const std::vector<Value2> &items, unsigned int min_support, unsigned int beam_width, double generalization, std::vector<std::pair<double,sequence<ordered_set<Value2> > > > &results) const {
+			typedef typename sequence<ordered_set<Value2> >::size_type size_type;
+			
+			unsigned int TP, FP;
+			beam_candidate element;
+			std::vector<std::pair<double,sequence<ordered_set<Value2> > > > beam;
+			std::vector<pattern_cover> covers;
+			std::vector<beam_candidate> next_beam;
+			
+			beam.push_back(element.pattern);
+			covers.resize(1);
+			start_cover(database, covers.back());
+			unsigned int threads = 1;
+			#ifdef _OPENMP
+			threads = omp_get_max_threads();
+			#endif
+			
+			while( !beam.empty() ) {
+				std::vector<std::pair<unsigned int,size_type> > units;
+				std::vector<std::vector<typename Elements::element_type> > beam_elements(beam.size());
+				for(unsigned int bb=0; bb < beam.size(); bb++) {
+					for(size_type ii=0; ii <= 2 * beam[bb].second.length(); ii++) {
+						units.push_back(std::pair<unsigned int,size_type>(bb, ii));
+					}
+					pattern_elements(elements, beam[bb].second, beam_elements[bb]);
+				}
+				
+				std::vector<std::vector<beam_candidate> > heaps(threads);
+				#pragma omp parallel if(threads > 1)
+				{
+					unsigned int thread = 0;
+					#ifdef _OPENMP
+					thread = omp_get_thread_num();
+					#endif
+					
+					beam_candidate candidate;
+					unsigned int candidate_TP, candidate_FP;
+					std::vector<typename Elements::element_type> candidate_elements;
+					
+					#pragma omp for schedule(dynamic)
+					for(int uu=0; uu < (int) units.size(); uu++) {
+						candidate.parent = units[uu].first;
+						
+						const sequence<ordered_set<Value2> > &parent = beam[candidate.parent].second;
+						candidate_elements = beam_elements[candidate.parent];
+						if(units[uu].second <= parent.length()) {
+							candidate_elements.insert(candidate_elements.begin() + units[uu].second, typename Elements::element_type());
+						}
+						
+						typename std::vector<Value2>::const_iterator items_iter = items.begin();
+						for(; items_iter != items.end(); ++items_iter) {
+							if(!extend(parent, units[uu].second, *items_iter, candidate.pattern.second, candidate.position)) {
+								continue;
+							}
+							elements.element(candidate.pattern.second[candidate.position], candidate_elements[candidate.position]);
+							
+							fitness(database, elements, covers[candidate.parent], parent.length(), candidate_elements, candidate.position, candidate_TP, candidate_FP);
+							if(candidate_TP >= min_support) {
+								candidate.pattern.first = candidate_TP/(candidate_FP+generalization);
+								keep_candidate(heaps[thread], candidate, beam_width);
+							}
+						}
+					}
+				}
+				
+				next_beam.clear();
+				for(unsigned int tt=0; tt < threads; tt++) {
+					next_beam.insert(next_beam.end(), heaps[tt].begin(), heaps[tt].end());
+				}
+				
+				std::make_heap(next_beam.begin(), next_beam.end());
+				
+				std::vector<std::pair<double,sequence<ordered_set<Value2> > > > parents;
+				std::vector<pattern_cover> parent_covers;
+				beam.swap(parents);
+				covers.swap(parent_covers);
+				
+				std::vector<typename Elements::element_type> selected_elements;
+				while(beam.size() < beam_width && next_beam.size() > 0) {
+					element = next_beam.front();
+					std::pop_heap(next_beam.begin(), next_beam.end());
+					next_beam.pop_back();
+					
+					beam.push_back(element.pattern);
+					covers.push_back(pattern_cover());
+					pattern_elements(elements, element.pattern.second, selected_elements);
+					fitness(database, elements, parent_covers[element.parent], parents[element.parent].second.length(), selected_elements, element.position, TP, FP, &covers.back());
+					
+					if(results.size() < beam_width) {
+						results.push_back(element.pattern);
+						std::push_heap(results.begin(), results.end(), std::greater<std::pair<double,sequence<ordered_set<Value2> > > >());
+					}
+					else if(element.pattern.first > results.front().first) {
+						std::pop_heap(results.begin(), results.end(), std::greater<std::pair<double,sequence<ordered_set<Value2> > > >());
+						results.back() = element.pattern;
+						std::push_heap(results.begin(), results.end(), std::greater<std::pair<double,sequence<ordered_set<Value2> > > >());
+					}
+				}
+				
+			}
+		}
+		
+		/* the elements of plain sequences are single items, matched by equality */
+		struct item_elements {
+			typedef Value2 element_type;
+			
+			const std::vector<const std::pair<bool,sequence<Value2> > *> &database;
+			
+			item_elements(const std::vector<const std::pair<bool,sequence<Value2> > *> &database) : database(database) {
+				
+			}
+			
+			void element(const Value2 &item, element_type &element) const {
+				element = item;
+			}
+			
+			bool find(unsigned int id, unsigned int &position, const element_type &element) const {
+				const sequence<Value2> &seq = database[id]->second;
+				
+				for(; position < seq.length(); position++) {
+					if(seq[position] == element) {
+						return true;
+					}
+				}
+				
+				return false;
+			}
+		};
+		
+		/* a sequence of the database projected on a pattern, with the ends of
+		 * the leftmost embeddings of the pattern without its last element (start)
+		 * and of the whole pattern (end) */
+		struct embedding {
+			unsigned int id;
+			unsigned int start;
+			unsigned int end;
+		};
+		
+		/* appends item to pattern as a new element, or for itemsets adds it to
+		 * the last element (an item extension) when it is larger than the items
+		 * there. false when there is no such pattern */
+		bool grow(sequence<Value2> &pattern, const Value2 &item, bool item_extension) const {
+			if(item_extension) {
+				return false;
+			}
+			
+			pattern.push_element(item);
+			return true;
 		}
-		/*void mine_patterns(typename std::vector<const std::pair<bool,sequence<Value2> *> >::iterator db_begin, typename std::vector<const std::pair<bool,sequence<Value2> *> >::iterator db_end, const std::vector<Value2> &items, unsigned int min_support, std::map<unsigned int,std::list<sequence<Value2> > > &return_patterns) const {
 		
+		bool grow(sequence<ordered_set<Value2> > &pattern, const Value2 &item, bool item_extension) const {
+			if(item_extension) {
+				return !pattern.empty() && pattern.push_item(item);
+			}
+			
+			pattern.push_element(ordered_set<Value2>(item));
+			return true;
 		}
-
-
-		void mine_patterns(typename std::vector<const std::pair<bool,sequence<ordered_set<Value2> > > *>::iterator db_begin, typename std::vector<const std::pair<bool,sequence<ordered_set<Value2> > > *>::iterator db_end, const std::vector<Value2> &items, unsigned int min_support, std::map<unsigned int,std::list<sequence<ordered_set<Value2> > > > &return_patterns) const {
 		
-		}*/
-
+		void shrink(sequence<Value2> &pattern, bool) const {
+			pattern.pop_element();
+		}
+		
+		void shrink(sequence<ordered_set<Value2> > &pattern, bool item_extension) const {
+			if(item_extension) {
+				pattern.pop_item();
+			}
+			else {
+				pattern.pop_element();
+			}
+		}
+		
+		/* the sequences of projected holding the pattern grown by element, its
+		 * new last element. an item extension replaces the last element, so its
+		 * embedding starts over from the end of the rest of the pattern */
+		template <typename Elements>
+		void project(const Elements &elements, const std::vector<embedding> &projected, const typename Elements::element_type &element, bool item_extension, std::vector<embedding> &result) const {
+			result.clear();
+			
+			typename std::vector<embedding>::const_iterator projected_iter = projected.begin();
+			for(; projected_iter != projected.end(); ++projected_iter) {
+				embedding next;
+				next.id = projected_iter->id;
+				next.start = item_extension ? projected_iter->start : projected_iter->end;
+				
+				unsigned int position = next.start;
+				if(elements.find(next.id, position, element)) {
+					next.end = position + 1;
+					result.push_back(next);
+				}
+			}
+		}
+		
+		/* adds pattern to results, a min-heap of the best top_k patterns */
+		void keep_pattern(std::vector<std::pair<double,sequence<Value1> > > &results, const std::pair<double,sequence<Value1> > &pattern, unsigned int top_k) const {
+			if(results.size() < top_k) {
+				results.push_back(pattern);
+				std::push_heap(results.begin(), results.end(), std::greater<std::pair<double,sequence<Value1> > >());
+			}
+			else if(pattern.first > results.front().first) {
+				std::pop_heap(results.begin(), results.end(), std::greater<std::pair<double,sequence<Value1> > >());
+				results.back() = pattern;
+				std::push_heap(results.begin(), results.end(), std::greater<std::pair<double,sequence<Value1> > >());
+			}
+		}
+		
+		/* position of item in the sorted items, items.size() when it is not there */
+		std::size_t item_index(const std::vector<Value2> &items, const Value2 &item) const {
+			typename std::vector<Value2>::const_iterator items_iter = std::lower_bound(items.begin(), items.end(), item);
+			if(items_iter == items.end() || item < *items_iter) {
+				return items.size();
+			}
+			
+			return items_iter - items.begin();
+		}
+		
+		/* counts the items of an element of the sequence marker, each item once
+		 * per sequence */
+		void count_items(const Value2 &item, const std::vector<Value2> &items, unsigned int marker, unsigned int *markers, unsigned int *counts) const {
+			std::size_t index = item_index(items, item);
+			if(index < items.size() && markers[index] != marker) {
+				markers[index] = marker;
+				counts[index]++;
+			}
+		}
+		
+		void count_items(const ordered_set<Value2> &set, const std::vector<Value2> &items, unsigned int marker, unsigned int *markers, unsigned int *counts) const {
+			typename ordered_set<Value2>::const_iterator set_iter = set.begin();
+			for(; set_iter != set.end(); ++set_iter) {
+				count_items(*set_iter, items, marker, markers, counts);
+			}
+		}
+		
+		/* the items that can join the last element of the pattern, those of the
+		 * elements after the rest of the pattern holding that element */
+		template <typename Elements>
+		void count_item_extensions(const std::vector<const std::pair<bool,sequence<ordered_set<Value2> > > *> &database, const Elements &elements, const embedding &projected, const typename Elements::element_type &last, const std::vector<Value2> &items, unsigned int marker, unsigned int *markers, unsigned int *counts) const {
+			unsigned int position = projected.start;
+			while(elements.find(projected.id, position, last)) {
+				count_items(database[projected.id]->second[position], items, marker, markers, counts);
+				position++;
+			}
+		}
+		
+		template <typename Elements>
+		void count_item_extensions(const std::vector<const std::pair<bool,sequence<Value2> > *> &, const Elements &, const embedding &, const typename Elements::element_type &, const std::vector<Value2> &, unsigned int, unsigned int *, unsigned int *) const {
+			
+		}
+		
+		/* the number of positive sequences holding each extension of pattern,
+		 * counts[ii] for items[ii] as a new element and counts[items.size() + ii]
+		 * within the last element. one pass over the projected positives
+		 * replaces projecting them on every item */
+		template <typename Sequence, typename Elements>
+		void count_extensions(const std::vector<const std::pair<bool,Sequence> *> &database, const Elements &elements, const std::vector<embedding> &positives, const sequence<Value1> &pattern, const std::vector<Value2> &items, std::vector<unsigned int> &counts) const {
+			std::size_t size = items.size();
+			std::vector<unsigned int> markers(2 * size, 0);
+			counts.assign(2 * size, 0);
+			
+			typename Elements::element_type last;
+			if(!pattern.empty()) {
+				elements.element(pattern.last(), last);
+			}
+			
+			for(unsigned int kk=0; kk < positives.size(); kk++) {
+				const Sequence &seq = database[positives[kk].id]->second;
+				for(typename Sequence::size_type position=positives[kk].end; position < seq.length(); position++) {
+					count_items(seq[position], items, kk + 1, &markers[0], &counts[0]);
+				}
+				
+				if(!pattern.empty()) {
+					count_item_extensions(database, elements, positives[kk], last, items, kk + 1, &markers[size], &counts[size]);
+				}
+			}
+		}
+		
+		/* grows pattern by every frequent item, as a new element and for itemsets
+		 * within its last element. a specialization of pattern holds at most the
+		 * TP positive sequences holding pattern, so its quality is at most
+		 * TP/(0+generalization). extensions are counted on the positive sequences
+		 * first, and those that cannot beat the worst of the best top_k patterns
+		 * found so far are pruned before anything is projected */
+		template <typename Sequence, typename Elements>
+		void depth_first_search(const std::vector<const std::pair<bool,Sequence> *> &database, const Elements &elements, const std::vector<embedding> &positives, const std::vector<embedding> &negatives, sequence<Value1> &pattern, const std::vector<Value2> &items, unsigned int min_support, unsigned int top_k, double generalization, std::vector<std::pair<double,sequence<Value1> > > &results) const {
+			std::vector<unsigned int> counts;
+			count_extensions(database, elements, positives, pattern, items, counts);
+			
+			typename Elements::element_type element;
+			std::vector<embedding> projected_positives;
+			std::vector<embedding> projected_negatives;
+			
+			for(std::size_t ii=0; ii < counts.size(); ii++) {
+				bool item_extension = ii >= items.size();
+				
+				unsigned int TP = counts[ii];
+				if(TP < min_support || (results.size() >= top_k && TP/generalization <= results.front().first)) {
+					continue;
+				}
+				
+				if(!grow(pattern, items[ii % items.size()], item_extension)) {
+					continue;
+				}
+				
+				elements.element(pattern.last(), element);
+				project(elements, positives, element, item_extension, projected_positives);
+				project(elements, negatives, element, item_extension, projected_negatives);
+				keep_pattern(results, std::pair<double,sequence<Value1> >(TP/(projected_negatives.size()+generalization), pattern), top_k);
+				
+				depth_first_search(database, elements, projected_positives, projected_negatives, pattern, items, min_support, top_k, generalization, results);
+				
+				shrink(pattern, item_extension);
+			}
+		}
+		
+		/* the exact best top_k patterns, found by a depth first search starting
+		 * from the whole database split by label */
+		template <typename Sequence, typename Elements>
+		void exhaustive_search(const std::vector<const std::pair<bool,Sequence> *> &database, const Elements &elements, const std::vector<Value2> &items, unsigned int min_support, unsigned int top_k, double generalization, std::vector<std::pair<double,sequence<Value1> > > &results) const {
+			if(top_k == 0) {
+				return;
+			}
+			
+			std::vector<embedding> positives;
+			std::vector<embedding> negatives;
+			
+			embedding start;
+			start.start = 0;
+			start.end = 0;
+			for(start.id=0; start.id < database.size(); start.id++) {
+				if(database[start.id]->first) {
+					positives.push_back(start);
+				}
+				else {
+					negatives.push_back(start);
+				}
+			}
+			
+			sequence<Value1> pattern;
+			depth_first_search(database, elements, positives, negatives, pattern, items, min_support, top_k, generalization, results);
+		}
+		
+		void exhaustive_search(std::vector<const std::pair<bool,sequence<Value2> > *> &database, const std::vector<Value2> &items, unsigned int min_support, unsigned int top_k, double generalization, std::vector<std::pair<double,sequence<Value2> > > &results) const {
+			exhaustive_search(database, item_elements(database), items, min_support, top_k, generalization, results);
+		}
+		
+		void exhaustive_search(std::vector<const std::pair<bool,sequence<ordered_set<Value2> > > *> &database, const std::vector<Value2> &items, unsigned int min_support, unsigned int top_k, double generalization, std::vector<std::pair<double,sequence<ordered_set<Value2> > > > &results) const {
+			if(itemset_masks<Value2>(items).words() <= max_mask_words) {
+				exhaustive_search(database, mask_elements(database, items), items, min_support, top_k, generalization, results);
+			}
+			else {
+				exhaustive_search(database, set_elements(database), items, min_support, top_k, generalization, results);
+			}
+		}
 };
 
 #endif